@@ -24,11 +24,122 @@
 
 // STANDARD DEFINITONS
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 // ARM CMSIS DSP DEFINITONS
 #include "arm_math.h"
 
+// Optional saturation telemetry, see EQ_TELEMETRY
+#ifndef EQ_TELEMETRY
+#define EQ_TELEMETRY 0 // 1 to compile in the saturation counters and band peaks
+#endif
+
+// Optional per-band level meters, see EQ_METERING
+#ifndef EQ_METERING
+#define EQ_METERING 0 // 1 to compute the per-band RMS and peak meters in the mix pass
+#endif
+
+// Optional multiband dynamics, see EQ_DYNAMICS
+#ifndef EQ_DYNAMICS
+#define EQ_DYNAMICS 0 // 1 to run a compressor/expander on every band before the mix
+#endif
+
+// Optional runtime switching of the bank rate, see EQ_MULTI_RATE
+#ifndef EQ_MULTI_RATE
+#define EQ_MULTI_RATE 0 // 1 to switch between the rates of Eq_ARM_coeffs.h at runtime
+#endif
+
+// Optional on-device design of the bands, see EQ_RUNTIME_DESIGN
+#ifndef EQ_RUNTIME_DESIGN
+#define EQ_RUNTIME_DESIGN 0 // 1 to retune the band centers at runtime
+#endif
+
+// Optional band gain presets, see EQ_PRESETS
+#ifndef EQ_PRESETS
+#define EQ_PRESETS 0 // 1 to apply band gain presets from the table of Eq_ARM_gains.h
+#endif
+
+// Optional per-stage cycle profiling, see EQ_PROFILE
+#ifndef EQ_PROFILE
+#define EQ_PROFILE 0 // 1 to time every stage of ARM_Equalizer into cycle histograms
+#endif
+
+// Optional block latency histograms of the driver loop, see EQ_LATENCY
+#ifndef EQ_LATENCY
+#define EQ_LATENCY 0 // 1 to keep latency histograms of every block in main()
+#endif
+
+// Cycle counter of the profiling, picked from the target unless set
+#define EQ_PROFILE_CLOCK_DWT    0 // DWT CYCCNT of the Cortex-M3/M4/M7/M33
+#define EQ_PROFILE_CLOCK_RDTSC  1 // Time stamp counter of x86 hosts
+#define EQ_PROFILE_CLOCK_PERF   2 // perf_event cycle counter of the calling thread on Linux
+#ifndef EQ_PROFILE_CLOCK
+#if defined(__x86_64__) || defined(__i386__)
+#define EQ_PROFILE_CLOCK EQ_PROFILE_CLOCK_RDTSC
+#elif defined(__linux__)
+#define EQ_PROFILE_CLOCK EQ_PROFILE_CLOCK_PERF
+#else
+#define EQ_PROFILE_CLOCK EQ_PROFILE_CLOCK_DWT
+#endif
+#endif
+
+// Builds without main() for host wrappers, see EQ_NO_MAIN
+#ifndef EQ_NO_MAIN
+#define EQ_NO_MAIN 0 // 1 to leave out main(), e.g. when included by Eq_ARM_module.c
+#endif
+
+// Both publish the exact per-band peaks, which the mix pass then has to track
+#define EQ_BAND_PEAKS (EQ_TELEMETRY || EQ_METERING)
+
+#if EQ_BAND_PEAKS || EQ_PRESETS || EQ_PROFILE || EQ_LATENCY
+#include <stdatomic.h>
+#endif
+
+// Clock of the latencies and the signals that export them on the host
+#if EQ_LATENCY && (EQ_PROFILE_CLOCK != EQ_PROFILE_CLOCK_DWT)
+#include <time.h>
+#if !EQ_NO_MAIN && defined(__unix__)
+#include <signal.h>
+#endif
+#endif
+
+// Cycle counter of the profiling on the host, and the thread exit that hands
+// back the histograms of a thread
+#if EQ_PROFILE && (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_RDTSC)
+#include <x86intrin.h>
+#elif EQ_PROFILE && (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_PERF)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if EQ_PROFILE && (EQ_PROFILE_CLOCK != EQ_PROFILE_CLOCK_DWT)
+#include <pthread.h>
+#endif
+
+// Coefficients of the bank (BIQUAD_COEFF, BIQUAD_COEFF_COUPLED), generated by
+// Eq_SciPy_ARM.py --headless
+#include "Eq_ARM_bank.h"
+
+// Coefficients of the bank for every rate, generated by Eq_SciPy_ARM.py
+#if EQ_MULTI_RATE
+#include "Eq_ARM_coeffs.h"
+#endif
+
+// Band gains of the presets on a 0.5 dB grid, generated by Eq_SciPy_ARM.py
+#if EQ_PRESETS
+#include "Eq_ARM_gains.h"
+#endif
+
+// The Butterworth design works on the complex poles
+#if EQ_RUNTIME_DESIGN
+#include <complex.h>
+#endif
+
 //******************************************************************************
 //  Defines
 //******************************************************************************
@@ -37,48 +148,403 @@
 #define NUMBER_OF_BIQUAD_STAGES 3   // Number of stages used for the filter
 #define NUMBER_OF_BANDS         6   // Number of equalization bands
 #define COEFFICIENT_POSTSHIFT   4   // Postshift used when creating the coeffs
+#define SAMPLE_RATE_HZ          16000 // Sampling rate the coefficients were designed for
+#ifndef SAMPLES_PER_TRANSFER
 #define SAMPLES_PER_TRANSFER    256 // Example of apply 256 samples at a time
+#endif
 #define SCALE_FACTOR            1   // Placeholder scale factor
 
+// Rate of the audio stream. The filter bank always runs at SAMPLE_RATE_HZ, any
+// other stream rate goes through the polyphase sample-rate converter (SRC).
+#ifndef STREAM_SAMPLE_RATE_HZ
+#define STREAM_SAMPLE_RATE_HZ   SAMPLE_RATE_HZ
+#endif
+
+// The stream is resampled by SRC_INTERPOLATION / SRC_DECIMATION to the bank rate
+// and back. Integer ratios run on the CMSIS FIR decimator and interpolator, the
+// 160/441 ratio of 44.1 kHz on the rational polyphase resampler of this file.
+#if (STREAM_SAMPLE_RATE_HZ == SAMPLE_RATE_HZ)
+#define SRC_INTERPOLATION       1
+#define SRC_DECIMATION          1
+#elif (STREAM_SAMPLE_RATE_HZ == 32000)
+#define SRC_INTERPOLATION       1
+#define SRC_DECIMATION          2
+#elif (STREAM_SAMPLE_RATE_HZ == 48000)
+#define SRC_INTERPOLATION       1
+#define SRC_DECIMATION          3
+#elif (STREAM_SAMPLE_RATE_HZ == 96000)
+#define SRC_INTERPOLATION       1
+#define SRC_DECIMATION          6
+#elif (STREAM_SAMPLE_RATE_HZ == 44100)
+#define SRC_INTERPOLATION       160
+#define SRC_DECIMATION          441
+#else
+#error "Unsupported STREAM_SAMPLE_RATE_HZ for a 16 kHz bank"
+#endif
+#define SRC_ENABLED             (SRC_DECIMATION != SRC_INTERPOLATION)
+
+// Anti-aliasing/anti-imaging prototype of the SRC, a Kaiser windowed sinc that
+// spans SRC_SPAN bank samples. It is flat up to ~5 kHz (the top band ends at
+// 4.5 kHz) and reaches ~70 dB where aliases would fold back below ~6.6 kHz.
+#define SRC_SPAN                16
+#define SRC_CUTOFF_HZ           7200.0
+#define SRC_KAISER_BETA         7.0
+#define SRC_NUM_TAPS            (SRC_SPAN * SRC_DECIMATION)
+#define SRC_DOWN_PHASE_LENGTH   ((SRC_NUM_TAPS + SRC_INTERPOLATION - 1) / SRC_INTERPOLATION)
+#define SRC_COEFF_LENGTH        (SRC_DOWN_PHASE_LENGTH * SRC_INTERPOLATION)
+
+// Gain of the input conversion that makes up for the prototype being designed
+// with the gain of the interpolator (SRC_DECIMATION) rather than the decimator
+#define SRC_INPUT_GAIN          ((q31_t) (2147483648.0 * SRC_INTERPOLATION / SRC_DECIMATION))
+
+// Samples per transfer at the stream rate, always a whole number of SRC periods
+#define STREAM_SAMPLES_PER_TRANSFER ((SAMPLES_PER_TRANSFER / SRC_INTERPOLATION) * SRC_DECIMATION)
+
+// Band gains applied in the mix, Q4.27 so that up to +24 dB can be set per band
+#define GAIN_FRACTION_BITS      27
+#define GAIN_UNITY              ((q31_t) 1 << GAIN_FRACTION_BITS)
+
+// Multiband dynamics (EQ_DYNAMICS): the gain computer runs once per sub-block of
+// DYNAMICS_BLOCK samples and the band gains ramp linearly in between
+#define DYNAMICS_BLOCK_SHIFT    5   // 32 samples, 2 ms at 16 kHz
+#define DYNAMICS_BLOCK          (1U << DYNAMICS_BLOCK_SHIFT)
+#define DYNAMICS_FLOOR_DB       (-40.0f) // Most attenuation the expander applies
+#define DYNAMICS_GAIN_MAX       2147483520.0f // Largest float32 below 2^31, INT32_MAX rounds up to 2^31
+
+// Band gain presets (EQ_PRESETS): the gain sets are handed from the control thread
+// to the audio thread through three slots, PRESET_FRESH marks a published set
+#define PRESET_SLOTS            3
+#define PRESET_FRESH            0x4U
+#define GAIN_PRESET_COUNT       4   // Example presets in GAIN_PRESETS
+
+// Block floating point: every block is shifted up as far as its peak allows
+#define HEADROOM_BITS           3   // Bits kept free above the block peak for the band gains
+#define BLOCK_EXPONENT_MAX      12  // Largest shift applied to quiet input blocks
+
+// Sample formats of the engine interface
+#define EQ_SAMPLES_Q15          0   // int16 samples, ARM_Equalizer()
+#define EQ_SAMPLES_Q31          1   // Full scale int32 samples, ARM_Equalizer_q31()
+
+// Stages of the equalizer with a saturation counter (EQ_TELEMETRY)
+#define EQ_STAGE_INPUT          0   // Input samples already at the Q15 (Q31) rails
+#define EQ_STAGE_RESCALE        1   // Filter state saturated by an exponent change
+#define EQ_STAGE_MIX            2   // Band sum saturated at the output range
+#define EQ_STAGE_COUNT          3
+
+// Stages timed by the profiling (EQ_PROFILE), in the order ARM_Equalizer runs
+// them. Each stage is charged the cycles since the end of the previous one.
+#define EQ_PROFILE_EXPONENT     0   // Input peak, block exponent and state rescale
+#define EQ_PROFILE_CONVERT      1   // Conversion to Q31 at the block exponent
+#define EQ_PROFILE_SRC_DOWN     2   // Resampling down to the bank rate
+#define EQ_PROFILE_BAND1        3   // Bandpass #1, the other bands follow in order
+#define EQ_PROFILE_MIX          (EQ_PROFILE_BAND1 + NUMBER_OF_BANDS) // Preset update, band gains and sum
+#define EQ_PROFILE_SRC_UP       (EQ_PROFILE_MIX + 1) // Resampling back up to the stream rate
+#define EQ_PROFILE_OUTPUT       (EQ_PROFILE_MIX + 2) // Conversion to int16
+#define EQ_PROFILE_TOTAL        (EQ_PROFILE_MIX + 3) // Whole call, including the telemetry
+#define EQ_PROFILE_STAGE_COUNT  (EQ_PROFILE_MIX + 4)
+#define EQ_PROFILE_BUCKETS      32  // Bucket b counts the calls of 2^b..2^(b+1)-1 cycles
+#ifndef EQ_PROFILE_THREADS
+#define EQ_PROFILE_THREADS      4   // Threads that can run ARM_Equalizer with profiling at once
+#endif
+#define EQ_PROFILE_SLOTS_ALL    (0xFFFFFFFFU >> (32 - EQ_PROFILE_THREADS))
+
+// Profiling hooks of ARM_Equalizer, they compile to nothing without EQ_PROFILE
+#if EQ_PROFILE
+#define EQ_PROFILE_BEGIN(block)        eq_profile_block_t block; eq_profile_begin(&block)
+#define EQ_PROFILE_STAGE(block, stage) eq_profile_stage(&block, stage)
+#define EQ_PROFILE_END(block)          eq_profile_end(&block)
+#else
+#define EQ_PROFILE_BEGIN(block)
+#define EQ_PROFILE_STAGE(block, stage)
+#define EQ_PROFILE_END(block)
+#endif
+
+// Block latency histograms (EQ_LATENCY), log-linear like HdrHistogram: every
+// power of two of ticks is split into EQ_LATENCY_HALF sub-buckets, so a latency
+// is recorded within 1/EQ_LATENCY_HALF of its value over the whole range
+#define EQ_LATENCY_SUB_BITS     7   // 128 sub-buckets in the first power of two, 64 in the others
+#define EQ_LATENCY_RANGE_BITS   36  // Latencies up to 2^36 ticks, 68 s in ns, longer ones are clamped
+#define EQ_LATENCY_HALF         (1U << (EQ_LATENCY_SUB_BITS - 1))
+#define EQ_LATENCY_BUCKETS      ((EQ_LATENCY_RANGE_BITS - EQ_LATENCY_SUB_BITS + 2) * EQ_LATENCY_HALF)
+#define EQ_LATENCY_CAPTURE_EQ   0   // Capture of the block to the end of ARM_Equalizer
+#define EQ_LATENCY_EQ_TRANSFER  1   // End of ARM_Equalizer to the end of the transfer
+#define EQ_LATENCY_TOTAL        2   // Capture to the end of the transfer
+#define EQ_LATENCY_COUNT        3
+
+// Ticks per second of the latency clock, nanoseconds on the host and the DWT
+// cycles on the Cortex-M, where it has to be set to the core clock
+#ifndef EQ_LATENCY_TICK_HZ
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_DWT)
+#define EQ_LATENCY_TICK_HZ      168000000U
+#else
+#define EQ_LATENCY_TICK_HZ      1000000000U
+#endif
+#endif
+
+// Cycle counter registers of the Cortex-M (EQ_PROFILE_CLOCK_DWT)
+#define EQ_DWT_CTRL             (*(volatile uint32_t*) 0xE0001000U)
+#define EQ_DWT_CYCCNT           (*(volatile uint32_t*) 0xE0001004U)
+#define EQ_DEMCR                (*(volatile uint32_t*) 0xE000EDFCU)
+#define EQ_DWT_CTRL_CYCCNTENA   0x1U
+#define EQ_DEMCR_TRCENA         0x01000000U
+
+// Band meters (EQ_METERING), smoothed once per block rather than per sample
+#define METER_SMOOTHING_SHIFT   3   // RMS smoothing, 2^-3 per block ~ 128 ms at 256 samples and 16 kHz
+#define METER_PEAK_DECAY_SHIFT  4   // Peak hold falls by 2^-4 per block
+
+// Biquad kernels that can be selected for the low-frequency bands 1-3
+#define LOW_BAND_KERNEL_DF1_32X64 0 // CMSIS 32x64-bit DF1, 64-bit output state
+#define LOW_BAND_KERNEL_DF1_EF    1 // 32x32-bit DF1 with first order error feedback
+#define LOW_BAND_KERNEL_COUPLED   2 // 32x32-bit coupled-form (Gold-Rader) sections
+
+#ifndef LOW_BAND_KERNEL
+#define LOW_BAND_KERNEL LOW_BAND_KERNEL_DF1_32X64 // Kernel used for bands 1-3
+#endif
+
+// The generated tables have to match the bank
+#if (EQ_BANK_STAGES != NUMBER_OF_BIQUAD_STAGES) || (EQ_BANK_BANDS != NUMBER_OF_BANDS) || \
+    (EQ_BANK_POSTSHIFT != COEFFICIENT_POSTSHIFT) || (EQ_BANK_SAMPLE_RATE_HZ != SAMPLE_RATE_HZ)
+#error "Eq_ARM_bank.h does not match the bank, regenerate it with Eq_SciPy_ARM.py --headless"
+#endif
+
+// The generated multi-rate tables have to match the bank, and the bank runs at the
+// stream rate then, anything else is a job for the SRC
+#if EQ_MULTI_RATE
+#if (EQ_RATE_STAGES != NUMBER_OF_BIQUAD_STAGES) || (EQ_RATE_BANDS != NUMBER_OF_BANDS) || \
+    (EQ_RATE_POSTSHIFT != COEFFICIENT_POSTSHIFT)
+#error "Eq_ARM_coeffs.h does not match the bank, regenerate it with Eq_SciPy_ARM.py"
+#endif
+#if SRC_ENABLED
+#error "EQ_MULTI_RATE switches the bank rate instead, leave STREAM_SAMPLE_RATE_HZ at SAMPLE_RATE_HZ"
+#endif
+#endif
+
+// The generated gain table has to use the format of the band gains
+#if EQ_PRESETS && (EQ_GAIN_FRACTION_BITS != GAIN_FRACTION_BITS)
+#error "Eq_ARM_gains.h does not match GAIN_FRACTION_BITS, regenerate it with Eq_SciPy_ARM.py"
+#endif
+
+// The stages of a block are tracked in a 32-bit mask
+#if EQ_PROFILE && (EQ_PROFILE_STAGE_COUNT > 32)
+#error "EQ_PROFILE supports up to 32 stages"
+#endif
+
+// The slots of the threads are handed out from a 32-bit mask
+#if EQ_PROFILE && ((EQ_PROFILE_THREADS < 1) || (EQ_PROFILE_THREADS > 32))
+#error "EQ_PROFILE supports 1 to 32 threads"
+#endif
+
+// The Cortex-M0/M0+ have no cycle counter
+#if EQ_PROFILE && (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_DWT) && defined(__ARM_ARCH_6M__)
+#error "EQ_PROFILE needs the DWT cycle counter, which the Cortex-M0 does not have"
+#endif
+
+// On-device design (EQ_RUNTIME_DESIGN) of the octave bands, like Eq_SciPy_ARM.py
+#define DESIGN_EDGE_LIMIT       0.9 // Highest band edge relative to the Nyquist frequency
+
+// The runtime design gives DF1 coefficients, which the coupled form cannot use
+#if EQ_RUNTIME_DESIGN && (LOW_BAND_KERNEL == LOW_BAND_KERNEL_COUPLED)
+#error "EQ_RUNTIME_DESIGN needs a DF1 LOW_BAND_KERNEL"
+#endif
+
+// Map the SRC onto the CMSIS FIR decimator and interpolator for integer ratios
+// or the rational resampler otherwise
+#if (SRC_INTERPOLATION == 1)
+#define SRC_DOWN_INST_T          arm_fir_decimate_instance_q31
+#define SRC_UP_INST_T            arm_fir_interpolate_instance_q31
+#else
+#define SRC_DOWN_INST_T          eq_fir_resample_ins_q31
+#define SRC_UP_INST_T            eq_fir_resample_ins_q31
+#endif
+
+// Map the selected low band kernel onto its instance, state and functions
+#if (LOW_BAND_KERNEL == LOW_BAND_KERNEL_DF1_32X64)
+#define LOW_BAND_STATE_T         q63_t
+#define LOW_BAND_STATE_PER_STAGE 4
+#define LOW_BAND_COEFF           BIQUAD_COEFF
+#define LOW_BAND_RATE_COEFF      EQ_RATE_BIQUAD_COEFF
+#define LOW_BAND_RATE_BANDS      NUMBER_OF_BANDS
+#define LOW_BAND_COEFF_PER_STAGE 5
+#define LOW_BAND_INST_T          arm_biquad_cas_df1_32x64_ins_q31
+#define LOW_BAND_INIT            arm_biquad_cas_df1_32x64_init_q31
+#define LOW_BAND_FILTER          arm_biquad_cas_df1_32x64_q31
+#elif (LOW_BAND_KERNEL == LOW_BAND_KERNEL_DF1_EF)
+#define LOW_BAND_STATE_T         q31_t
+#define LOW_BAND_STATE_PER_STAGE 5
+#define LOW_BAND_COEFF           BIQUAD_COEFF
+#define LOW_BAND_RATE_COEFF      EQ_RATE_BIQUAD_COEFF
+#define LOW_BAND_RATE_BANDS      NUMBER_OF_BANDS
+#define LOW_BAND_COEFF_PER_STAGE 5
+#define LOW_BAND_INST_T          eq_biquad_cas_df1_ef_ins_q31
+#define LOW_BAND_INIT            eq_biquad_cas_df1_ef_init_q31
+#define LOW_BAND_FILTER          eq_biquad_cas_df1_ef_q31
+#elif (LOW_BAND_KERNEL == LOW_BAND_KERNEL_COUPLED)
+#define LOW_BAND_STATE_T         q31_t
+#define LOW_BAND_STATE_PER_STAGE 2
+#define LOW_BAND_COEFF           BIQUAD_COEFF_COUPLED
+#define LOW_BAND_RATE_COEFF      EQ_RATE_BIQUAD_COEFF_COUPLED
+#define LOW_BAND_RATE_BANDS      EQ_RATE_COUPLED_BANDS
+#define LOW_BAND_COEFF_PER_STAGE 6
+#define LOW_BAND_INST_T          eq_biquad_cas_coupled_ins_q31
+#define LOW_BAND_INIT            eq_biquad_cas_coupled_init_q31
+#define LOW_BAND_FILTER          eq_biquad_cas_coupled_q31
+#else
+#error "Unknown LOW_BAND_KERNEL selection"
+#endif
+
+//******************************************************************************
+//  Type Definitions
+//******************************************************************************
+
+// Instance structure for the Q31 Biquad cascade with error feedback. It follows
+// the layout of the CMSIS arm_biquad_casd_df1_inst_q31 structure, the only
+// difference being a fifth state variable per stage holding the truncation error.
+typedef struct
+{
+    uint32_t     numStages; // Number of 2nd order stages in the filter
+    q31_t*       pState;    // Points to the array of state variables (5 * numStages)
+    const q31_t* pCoeffs;   // Points to the array of coefficients (5 * numStages)
+    uint8_t      postShift; // Additional shift, in bits, applied to each output sample
+} eq_biquad_cas_df1_ef_ins_q31;
+
+// Instance structure for the Q31 coupled-form Biquad cascade. Each stage has the
+// 6 coefficients {d, g, cr, ci, c1, c2} and the 2 state variables {v1, v2}.
+typedef struct
+{
+    uint32_t     numStages; // Number of 2nd order stages in the filter
+    q31_t*       pState;    // Points to the array of state variables (2 * numStages)
+    const q31_t* pCoeffs;   // Points to the array of coefficients (6 * numStages)
+    uint8_t      postShift; // Additional shift, in bits, applied to each output sample
+} eq_biquad_cas_coupled_ins_q31;
+
+// Instance structure for the Q31 polyphase rational resampler, which interpolates
+// by L and decimates by M with a single FIR prototype of (phaseLength * L) taps.
+// Like the CMSIS FIR functions it keeps (phaseLength - 1) past input samples.
+typedef struct
+{
+    uint16_t     L;           // Interpolation factor, number of polyphase branches
+    uint16_t     M;           // Decimation factor
+    uint16_t     phaseLength; // Taps of every polyphase branch
+    uint32_t     position;    // Position of the next output in input samples * L
+    const q31_t* pCoeffs;     // Points to the prototype filter (phaseLength * L)
+    q31_t*       pState;      // Points to the state variables (phaseLength + blockSize - 1)
+} eq_fir_resample_ins_q31;
+
+#if EQ_DYNAMICS
+// Settings of the compressor/expander of one band. Above the compressor threshold
+// the level is reduced by the compressor ratio, below the expander threshold it is
+// pushed down by the expander ratio (downward expansion).
+typedef struct
+{
+    float32_t compThresholdDb; // Compressor threshold [dBFS]
+    float32_t compRatio;       // Compressor ratio, e.g. 4 for 4:1
+    float32_t expThresholdDb;  // Expander threshold [dBFS]
+    float32_t expRatio;        // Expander ratio, e.g. 2 for 1:2
+    float32_t attackMs;        // Envelope attack time [ms]
+    float32_t releaseMs;       // Envelope release time [ms]
+    float32_t makeupDb;        // Makeup gain [dB]
+} eq_dynamics_params_t;
+#endif
+
+#if EQ_TELEMETRY
+// Saturation telemetry of the equalizer. It is only written by the audio thread,
+// once per block, and every field can be read lock-free from a monitoring thread
+// with atomic_load(). The monitor may atomic_exchange() the bandPeakMax entries
+// back to 0 to get the peak per read interval. Note that arm_q31_to_q15 truncates
+// and cannot clip, a sum beyond the output range is counted in EQ_STAGE_MIX.
+typedef struct
+{
+    _Atomic uint32_t blocks;                       // Number of processed blocks
+    _Atomic uint32_t saturations[EQ_STAGE_COUNT];  // Saturated samples per stage
+    _Atomic q31_t    bandPeak[NUMBER_OF_BANDS];    // Band output peak of the last block
+    _Atomic q31_t    bandPeakMax[NUMBER_OF_BANDS]; // Band output peak since the last reset
+    _Atomic int32_t  exponent;                     // Block exponent of the last block
+} eq_telemetry_t;
+#endif
+
+#if EQ_METERING
+// Per-band level meters for dashboards, published once per block. The levels are
+// Q31 relative to the int16 full scale (the block exponent has been removed) and
+// can be read lock-free with atomic_load(), sequence counts the published blocks.
+typedef struct
+{
+    _Atomic uint32_t sequence;              // Number of published blocks
+    _Atomic q31_t    rms[NUMBER_OF_BANDS];  // Smoothed RMS level of every band
+    _Atomic q31_t    peak[NUMBER_OF_BANDS]; // Decaying peak hold of every band
+} eq_meter_t;
+#endif
+
+#if EQ_PROFILE
+// Cycle histogram of one stage
+typedef struct
+{
+    uint32_t count;                       // Number of timed calls
+    uint32_t min;                         // Fewest cycles of a call
+    uint32_t max;                         // Most cycles of a call
+    uint64_t sum;                         // Cycles of all calls
+    uint32_t buckets[EQ_PROFILE_BUCKETS]; // Calls per power of two of cycles
+} eq_profile_histogram_t;
+
+// Histograms of all stages of one thread. Only the owning thread writes them,
+// once per block, and the sequence is odd while it does, so that a monitoring
+// thread can take a consistent copy without ever blocking the audio thread.
+typedef struct
+{
+    _Atomic uint32_t       sequence;                      // Odd while the block is added
+    eq_profile_histogram_t stages[EQ_PROFILE_STAGE_COUNT]; // Histograms of every stage
+} eq_profile_t;
+
+// Timestamps of the block being timed, on the stack of ARM_Equalizer
+typedef struct
+{
+    eq_profile_t* pProfile;                      // Histograms of this thread, NULL if none was left
+    uint32_t      start;                         // Cycle count at the start of the call
+    uint32_t      last;                          // Cycle count at the end of the last stage
+    uint32_t      timed;                         // Mask of the stages timed in this call
+    uint32_t      cycles[EQ_PROFILE_STAGE_COUNT]; // Cycles of every stage in this call
+} eq_profile_block_t;
+#endif
+
+#if EQ_LATENCY
+// Latency histogram of one interval of the driver loop, in ticks of the clock
+typedef struct
+{
+    uint64_t count;                      // Number of recorded blocks
+    uint64_t max;                        // Exact largest latency
+    uint32_t buckets[EQ_LATENCY_BUCKETS]; // Blocks per sub-bucket, see eq_latency_index()
+} eq_latency_histogram_t;
+#endif
+
 //******************************************************************************
 //  Constant Variables
 //******************************************************************************
 
-// 3 stages * 6 bands * 5 coefficients for each biquad
-// Note that this was copied from the Python terminal output
-const q31_t BIQUAD_COEFF[NUMBER_OF_BIQUAD_STAGES * NUMBER_OF_BANDS * 5] =
-{
-    // Bandpass #1: 70.7 Hz to 141.4 Hz:
-    349, 699, 349 264555182, -130541587, 
-    134217728, -67, -134219283, 265663083, -131823456, 
-    134217728, -268434645, 134216917, 267019266, -132913256,
-
-
-    // Bandpass #2: 141.4 Hz to 282.8 Hz
-    2721, 5441, 2721, 260375768, -126963381, 
-    134217728, -67, -134219283, 262193941, -129474301, 
-    134217728, -268434645, 134216917, 265393561, -131620459,
-	
-    // Bandpass #3: 282.8 Hz to 565.7 Hz
-    20635, 41271, 20635, 251164150, -120080476, 
-    134217728, -67, -134219283, 253261157, -124917151, 
-    134217728, -268434645, 134216917, 261522959, -129065288,
-
-    // Bandpass #4: 565.7 Hz to 1131.4 Hz
-    456703, 913403, 456700, 204512719, -95574292,
-    134217728, -67, -134219283, 194736516, -108736401,
-    134217728, -268434645, 134216917, 238200252, -119098659,
-
-    // Bandpass #5: 1131.4 Hz to 2262.7 Hz:
-    149046, 298092, 149046, 229631975, -107282897, 
-    134217728, -67, -134219283, 228128773, -116401482, 
-    134217728, -268434645, 134216917, 251380082, -124047183,
-	
-    // Bandpass #6: 2262.7 Hz to 4525.5 Hz
-    149046, 298092, 149046, 229631975, -107282897 
-    134217728, -67, -134219283, 228128773, -116401482, 
-    134217728, -268434645, 134216917, 251380082, -124047183
+#if EQ_DYNAMICS
+// Compressor/expander settings of every band, these are only example values
+const eq_dynamics_params_t DYNAMICS_PARAMS[NUMBER_OF_BANDS] =
+{
+    // Threshold, ratio, expander threshold, ratio, attack, release, makeup
+    { -20.0f, 4.0f, -60.0f, 2.0f, 10.0f, 200.0f, 0.0f }, // Bandpass #1
+    { -20.0f, 4.0f, -60.0f, 2.0f, 10.0f, 150.0f, 0.0f }, // Bandpass #2
+    { -20.0f, 3.0f, -60.0f, 2.0f,  5.0f, 100.0f, 0.0f }, // Bandpass #3
+    { -20.0f, 3.0f, -60.0f, 2.0f,  5.0f, 100.0f, 0.0f }, // Bandpass #4
+    { -20.0f, 2.0f, -60.0f, 2.0f,  2.0f,  50.0f, 0.0f }, // Bandpass #5
+    { -20.0f, 2.0f, -60.0f, 2.0f,  2.0f,  50.0f, 0.0f }, // Bandpass #6
+};
+#endif
+
+#if EQ_PRESETS
+// Band gains of some presets in steps of 1 / EQ_GAIN_STEPS_PER_DB dB, these are
+// only example values
+const int8_t GAIN_PRESETS[GAIN_PRESET_COUNT][NUMBER_OF_BANDS] =
+{
+    // Bandpass #1 .. #6
+    {   0,   0,   0,   0,   0,   0 }, // Flat
+    {  12,   8,   4,   0,   0,   0 }, // Bass boost, +6 dB at 100 Hz
+    { -12,  -6,   0,   6,   6,   0 }, // Voice
+    {   0,   0,   0,   4,   8,  12 }, // Treble boost, +6 dB at 3.2 kHz
 };
+#endif
 
 //******************************************************************************
 //  Static Variables
@@ -86,9 +552,10 @@ const q31_t BIQUAD_COEFF[NUMBER_OF_BIQUAD_STAGES * NUMBER_OF_BANDS * 5] =
 
 // 4 * (stages) as the 4 state variables typically represent the past two input...
 // ...samples (x[n-1] and x[n-2]) and the past two output samples (y[n-1] and y[n-2])
-static q63_t biquadStateBand1Q31[4 * NUMBER_OF_BIQUAD_STAGES];
-static q63_t biquadStateBand2Q31[4 * NUMBER_OF_BIQUAD_STAGES];
-static q63_t biquadStateBand3Q31[4 * NUMBER_OF_BIQUAD_STAGES];
+// The low bands use the state type and size of the selected LOW_BAND_KERNEL
+static LOW_BAND_STATE_T biquadStateBand1Q31[LOW_BAND_STATE_PER_STAGE * NUMBER_OF_BIQUAD_STAGES];
+static LOW_BAND_STATE_T biquadStateBand2Q31[LOW_BAND_STATE_PER_STAGE * NUMBER_OF_BIQUAD_STAGES];
+static LOW_BAND_STATE_T biquadStateBand3Q31[LOW_BAND_STATE_PER_STAGE * NUMBER_OF_BIQUAD_STAGES];
 static q31_t biquadStateBand4Q31[4 * NUMBER_OF_BIQUAD_STAGES];
 static q31_t biquadStateBand5Q31[4 * NUMBER_OF_BIQUAD_STAGES];
 static q31_t biquadStateBand6Q31[4 * NUMBER_OF_BIQUAD_STAGES];
@@ -105,12 +572,125 @@ static q31_t outputB4[SAMPLES_PER_TRANSFER];
 static q31_t outputB5[SAMPLES_PER_TRANSFER];
 static q31_t outputB6[SAMPLES_PER_TRANSFER];
 
+#if SRC_ENABLED
+// SRC prototype, designed by ARM_Equalizer_init(), and the filter states. The
+// stream rate buffer holds the converted input until it has been decimated and
+// is reused for the interpolated output afterwards.
+static q31_t srcCoeffs[SRC_COEFF_LENGTH];
+static q31_t srcDownState[SRC_DOWN_PHASE_LENGTH + STREAM_SAMPLES_PER_TRANSFER - 1];
+static q31_t srcUpState[SRC_SPAN + SAMPLES_PER_TRANSFER - 1];
+static q31_t q31Stream[STREAM_SAMPLES_PER_TRANSFER];
+static SRC_DOWN_INST_T srcDown;
+static SRC_UP_INST_T   srcUp;
+#endif
+
+#if EQ_RUNTIME_DESIGN
+// Coefficients designed by ARM_Equalizer_retune(), same layout as BIQUAD_COEFF,
+// and the rate of the bank they are designed for
+static q31_t    designedCoeff[NUMBER_OF_BIQUAD_STAGES * NUMBER_OF_BANDS * 5];
+static uint32_t bankSampleRate = SAMPLE_RATE_HZ;
+#endif
+
+// The band buffers in band order, for the stages that loop over all bands
+static q31_t* const outputBands[NUMBER_OF_BANDS] =
+{
+    outputB1, outputB2, outputB3, outputB4, outputB5, outputB6
+};
+
+// Block floating point state: exponent of the block that is being processed (the
+// input is scaled by 2^exponent) and the OR of the band output magnitudes of the
+// last block, which has the same leading bit as their peak.
+static int32_t blockExponent = -HEADROOM_BITS;
+static q31_t   blockBandPeak = 0;
+
+// Gain of every band applied in the mix (Q4.27). Without EQ_DYNAMICS it is the
+// static band gain, with it the gain ramps by bandGainStep every sample towards
+// the static gain times the output of the gain computer.
+static q31_t bandMixGain[NUMBER_OF_BANDS];
+static q31_t bandGain[NUMBER_OF_BANDS];
+
+#if EQ_DYNAMICS
+// Envelope follower state and its per sub-block attack/release coefficients
+static q31_t     bandGainStep[NUMBER_OF_BANDS];
+static float32_t dynamicsEnvelope[NUMBER_OF_BANDS];
+static float32_t dynamicsAttack[NUMBER_OF_BANDS];
+static float32_t dynamicsRelease[NUMBER_OF_BANDS];
+#endif
+
+#if EQ_PRESETS
+// Band gain sets of the presets in a triple buffer: the control thread fills slot
+// presetBack, the audio thread reads slot presetFront, and the two swap their slot
+// with presetMiddle. Neither side ever waits and the last published set wins.
+static q31_t            presetGains[PRESET_SLOTS][NUMBER_OF_BANDS];
+static uint32_t         presetBack = 0;   // Only used by the control thread
+static uint32_t         presetFront = 1;  // Only used by the audio thread
+static _Atomic uint32_t presetMiddle = 2; // Slot index | PRESET_FRESH once published
+#endif
+
+#if EQ_BAND_PEAKS
+// Exact peak magnitude of every band in the current block
+static q31_t blockBandPeaks[NUMBER_OF_BANDS];
+#endif
+
+#if EQ_TELEMETRY
+// Telemetry read by the monitoring thread, and the counts of the current block
+static eq_telemetry_t equalizerTelemetry;
+static uint32_t       blockSaturations[EQ_STAGE_COUNT];
+#endif
+
+#if EQ_METERING
+// Meters read by the dashboard, the sum of squares of the current block (Q46) and
+// the smoothed mean square (Q46) and peak hold (Q31) of every band
+static eq_meter_t equalizerMeters;
+static q63_t      blockBandEnergy[NUMBER_OF_BANDS];
+static q63_t      meterMeanSquare[NUMBER_OF_BANDS];
+static q31_t      meterPeak[NUMBER_OF_BANDS];
+#endif
+
+#if EQ_PROFILE
+// Histograms of the threads that run ARM_Equalizer. A thread claims the lowest
+// free slot and hands it back when it exits, the next thread adds to the same
+// histograms. There are no threads on the Cortex-M, everywhere else every
+// running thread keeps its own slot.
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_DWT)
+#define EQ_PROFILE_THREAD_LOCAL
+#else
+#define EQ_PROFILE_THREAD_LOCAL _Thread_local
+#endif
+static eq_profile_t                         profileThreads[EQ_PROFILE_THREADS];
+static _Atomic uint32_t                     profileSlotsClaimed = 0; // Slots of the running threads
+static _Atomic uint32_t                     profileSlotsTimed = 0;   // Slots that were ever claimed
+static EQ_PROFILE_THREAD_LOCAL eq_profile_t* pThreadProfile = NULL;
+#if (EQ_PROFILE_CLOCK != EQ_PROFILE_CLOCK_DWT)
+static pthread_once_t                       profileKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t                        profileKey;             // Runs eq_profile_release at thread exit
+static uint32_t                             profileKeyCreated = 0;
+#endif
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_PERF)
+static EQ_PROFILE_THREAD_LOCAL int          threadCycleCounter = -1; // perf_event of this thread
+static EQ_PROFILE_THREAD_LOCAL const volatile struct perf_event_mmap_page* pThreadCounterPage = NULL; // For rdpmc
+#endif
+#endif
+
+#if EQ_LATENCY
+// Latency histograms, only touched by the driver loop. Other threads, interrupts
+// and signal handlers ask for an export or the shutdown through the flags, so the
+// histograms are never read while they change.
+static eq_latency_histogram_t latencyHistograms[EQ_LATENCY_COUNT];
+static _Atomic uint32_t       latencyExportRequest = 0;
+static _Atomic uint32_t       latencyRunning = 1;
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_DWT)
+static uint32_t               latencyCycleLast = 0;  // Last DWT count, to extend it to 64 bits
+static uint64_t               latencyCycleHigh = 0;  // Wraps of the DWT count, times 2^32
+#endif
+#endif
+
 // Structs for biquad inits:
 // It is noticed that Direct Form I is used as for numerical calculations it is
 // more robust for data types.
-static arm_biquad_cas_df1_32x64_ins_q31 B1;
-static arm_biquad_cas_df1_32x64_ins_q31 B2;
-static arm_biquad_cas_df1_32x64_ins_q31 B3;
+static LOW_BAND_INST_T B1;
+static LOW_BAND_INST_T B2;
+static LOW_BAND_INST_T B3;
 static arm_biquad_casd_df1_inst_q31 B4;
 static arm_biquad_casd_df1_inst_q31 B5;
 static arm_biquad_casd_df1_inst_q31 B6;
@@ -122,15 +702,122 @@ static arm_biquad_casd_df1_inst_q31 B6;
 // Example functions of the init and the audio equalization
 static void ARM_Equalizer_init(void);
 static void ARM_Equalizer(int16_t* pSrc, int16_t* pDest, uint16_t blocksize);
+__attribute__((unused)) static void ARM_Equalizer_q31(const q31_t* pSrc, q31_t* pDest, uint16_t blocksize);
+static inline void ARM_Equalizer_block(const void* pSrc, void* pDest, uint16_t blocksize, uint32_t format);
+
+// Block floating point stages of the equalizer
+static int32_t ARM_Equalizer_exponent(const int16_t* pSrc, uint16_t blocksize);
+static int32_t ARM_Equalizer_exponent_q31(const q31_t* pSrc, uint16_t blocksize);
+static int32_t ARM_Equalizer_exponent_update(int32_t exponent);
+static void ARM_Equalizer_rescale(int32_t shift);
+static void ARM_Equalizer_convert(const int16_t* pSrc, int32_t exponent, uint16_t blocksize);
+static void ARM_Equalizer_convert_q31(const q31_t* pSrc, int32_t exponent, uint16_t blocksize);
+static void ARM_Equalizer_mix(int32_t exponent, uint16_t blocksize);
+
+#if EQ_DYNAMICS
+// Multiband dynamics gain computer
+static void ARM_Equalizer_dynamics_init(uint32_t sampleRate);
+static void ARM_Equalizer_dynamics(const q31_t* pPeaks, int32_t exponent);
+#endif
+
+#if EQ_PRESETS
+// Band gain presets
+__attribute__((unused)) static arm_status ARM_Equalizer_apply_preset(const int8_t* pSteps);
+static void ARM_Equalizer_preset_update(void);
+#endif
+
+#if EQ_MULTI_RATE
+// Switches the bank to another rate of Eq_ARM_coeffs.h
+__attribute__((unused)) static arm_status ARM_Equalizer_set_rate(uint32_t sampleRate);
+#endif
+
+#if EQ_RUNTIME_DESIGN
+// On-device Butterworth design of the octave bands
+__attribute__((unused)) static arm_status ARM_Equalizer_retune(float64_t baseFrequency);
+static arm_status eq_butter_bandpass_q31(float64_t lowcut, float64_t highcut, float64_t sampleRate,
+                                         q31_t* pCoeffs);
+#endif
+
+// Polyphase sample-rate conversion between the stream and the bank
+__attribute__((unused)) static float64_t eq_bessel_i0(float64_t x);
+__attribute__((unused)) static void eq_src_design_q31(q31_t* pCoeffs, uint32_t numTaps, uint32_t length,
+                                                      float64_t cutoff, float64_t gain);
+__attribute__((unused)) static void eq_fir_resample_init_q31(eq_fir_resample_ins_q31* S, uint16_t L, uint16_t M,
+                                                             uint16_t phaseLength, const q31_t* pCoeffs,
+                                                             q31_t* pState, uint32_t blockSize);
+__attribute__((unused)) static uint32_t eq_fir_resample_q31(eq_fir_resample_ins_q31* S, const q31_t* pSrc,
+                                                            q31_t* pDst, uint32_t blockSize);
+static uint32_t eq_shift_state_q31(q31_t* pState, uint32_t count, int32_t shift);
+__attribute__((unused)) static uint32_t eq_shift_state_q63(q63_t* pState, uint32_t count, int32_t shift);
+
+#if EQ_TELEMETRY
+// Saturation telemetry
+static void ARM_Equalizer_telemetry_publish(int32_t exponent);
+__attribute__((unused)) static const eq_telemetry_t* ARM_Equalizer_telemetry(void);
+#endif
+
+#if EQ_METERING
+// Per-band level meters
+static void ARM_Equalizer_meter_publish(int32_t exponent, uint16_t blocksize);
+__attribute__((unused)) static const eq_meter_t* ARM_Equalizer_meters(void);
+static q31_t eq_sqrt_q63(q63_t value);
+#endif
+
+#if EQ_PROFILE
+// Per-stage cycle profiling
+static uint32_t eq_profile_cycles(void);
+static eq_profile_t* eq_profile_claim(void);
+#if (EQ_PROFILE_CLOCK != EQ_PROFILE_CLOCK_DWT)
+static void eq_profile_key_create(void);
+static void eq_profile_release(void* pProfile);
+#endif
+static void eq_profile_begin(eq_profile_block_t* pBlock);
+static void eq_profile_stage(eq_profile_block_t* pBlock, uint32_t stage);
+static void eq_profile_end(eq_profile_block_t* pBlock);
+__attribute__((unused)) static uint32_t ARM_Equalizer_profile(eq_profile_histogram_t* pStages);
+#endif
+
+#if EQ_LATENCY
+// Block latency histograms of the driver loop, unused without main()
+__attribute__((unused)) static void ARM_Equalizer_latency_init(void);
+__attribute__((unused)) static uint64_t eq_latency_now(void);
+__attribute__((unused)) static uint64_t eq_latency_extend(uint64_t stamp);
+static uint32_t eq_latency_index(uint64_t ticks);
+__attribute__((unused)) static void ARM_Equalizer_latency_record(uint64_t captured, uint64_t equalized,
+                                                                 uint64_t transferred);
+__attribute__((unused)) static void ARM_Equalizer_latency_export(FILE* pFile);
+__attribute__((unused)) static void ARM_Equalizer_latency_request(void);
+__attribute__((unused)) static void ARM_Equalizer_latency_shutdown(void);
+#if !EQ_NO_MAIN && defined(__unix__) && (EQ_PROFILE_CLOCK != EQ_PROFILE_CLOCK_DWT)
+static void eq_latency_signal(int signalNumber);
+#endif
+#endif
+
+// Q31 Biquad cascade with first order error feedback (noise shaping), the
+// alternative low band kernels are marked unused as only one is selected
+__attribute__((unused)) static void eq_biquad_cas_df1_ef_init_q31(eq_biquad_cas_df1_ef_ins_q31* S, uint8_t numStages,
+                                                                  const q31_t* pCoeffs, q31_t* pState, uint8_t postShift);
+__attribute__((unused)) static void eq_biquad_cas_df1_ef_q31(const eq_biquad_cas_df1_ef_ins_q31* S, const q31_t* pSrc,
+                                                             q31_t* pDst, uint32_t blockSize);
+
+// Q31 coupled-form (Gold-Rader) Biquad cascade
+__attribute__((unused)) static void eq_biquad_cas_coupled_init_q31(eq_biquad_cas_coupled_ins_q31* S, uint8_t numStages,
+                                                                   const q31_t* pCoeffs, q31_t* pState, uint8_t postShift);
+__attribute__((unused)) static void eq_biquad_cas_coupled_q31(const eq_biquad_cas_coupled_ins_q31* S, const q31_t* pSrc,
+                                                              q31_t* pDst, uint32_t blockSize);
 
 // Example of user custom functions for obtaining and transfering data
-__attribute__((weak)) void user_custom_data_obtaining(uint16_t* databuf);
-__attribute__((weak)) void user_custom_data_transfer(uint16_t* databuf);
+__attribute__((weak)) void user_custom_data_obtaining(int16_t* databuf);
+__attribute__((weak)) void user_custom_data_transfer(int16_t* databuf);
+#if EQ_LATENCY
+__attribute__((weak)) void user_custom_data_obtaining_timed(int16_t* databuf, uint64_t* pCaptured);
+#endif
 
 //******************************************************************************
 //  Functions
 //******************************************************************************
 
+#if !EQ_NO_MAIN
 /**
  *******************************************************************************
  * @brief:     Main function of the file
@@ -148,22 +835,63 @@ int main(void)
     // Initialize the filters before using them
     ARM_Equalizer_init();
 
+#if EQ_LATENCY
+    // Latency histograms of the loop below, on the host SIGUSR1 exports them and
+    // SIGINT/SIGTERM end the loop, which exports them once more
+    ARM_Equalizer_latency_init();
+#if defined(__unix__) && (EQ_PROFILE_CLOCK != EQ_PROFILE_CLOCK_DWT)
+    signal(SIGUSR1, eq_latency_signal);
+    signal(SIGINT, eq_latency_signal);
+    signal(SIGTERM, eq_latency_signal);
+#endif
+#endif
+
     // Example of using the filter through some type of thread
     // Note that the way to obtain the data has been left out
+#if EQ_LATENCY
+    while (atomic_load_explicit(&latencyRunning, memory_order_relaxed))
+#else
     while (1)
+#endif
     {
-        // Assume (SAMPLES_PER_TRANSFER) of data is placed into the databuf
+        // Assume (STREAM_SAMPLES_PER_TRANSFER) of data is placed into the databuf,
+        // this is SAMPLES_PER_TRANSFER unless the stream needs the SRC
+#if EQ_LATENCY
+        // The hook reports when the block was captured, e.g. stamped by the DMA/ISR
+        // completion, so that the wait for the loop is part of the latency
+        uint64_t captured;
+        user_custom_data_obtaining_timed(databuf, &captured);
+        captured = eq_latency_extend(captured);
+#else
         user_custom_data_obtaining(databuf);
+#endif
 
         // Filter this buffer
-        ARM_Equalizer(databuf, databuf, SAMPLES_PER_TRANSFER);
+        ARM_Equalizer(databuf, databuf, STREAM_SAMPLES_PER_TRANSFER);
+#if EQ_LATENCY
+        const uint64_t equalized = eq_latency_now();
+#endif
 
-        // Assume (SAMPLES_PER_TRANSFER) of data is transferred somewhere else
+        // Assume (STREAM_SAMPLES_PER_TRANSFER) of data is transferred somewhere else
         user_custom_data_transfer(databuf);
+
+#if EQ_LATENCY
+        ARM_Equalizer_latency_record(captured, equalized, eq_latency_now());
+        if (atomic_exchange_explicit(&latencyExportRequest, 0U, memory_order_relaxed) != 0)
+        {
+            ARM_Equalizer_latency_export(stdout);
+        }
+#endif
     }
 
+#if EQ_LATENCY
+    // Latencies of the whole run at shutdown
+    ARM_Equalizer_latency_export(stdout);
+#endif
+
     return 0;
 }
+#endif
 
 /**
  *******************************************************************************
@@ -171,7 +899,12 @@ int main(void)
  * @notes:  Note that for improved noise performance, we use high-precision
  *          32x64-bit Biquad filters for the low-frequency bands and standard
  *          32x32-bit Biquad filters for the high-frequency bands. But any
- *          could be used.
+ *          could be used. Setting LOW_BAND_KERNEL to LOW_BAND_KERNEL_DF1_EF
+ *          runs bands 1-3 on the error feedback kernel instead, which keeps
+ *          most of the low-frequency noise performance at close to 32x32 cost.
+ *          LOW_BAND_KERNEL_COUPLED uses coupled-form sections, which are far
+ *          less sensitive to coefficient quantization for poles close to z = 1
+ *          (see compare_biquad_structures() in Eq_SciPy_ARM.py).
  * @param:  N/A
  * @return: N/A
  *******************************************************************************
@@ -182,18 +915,19 @@ static void ARM_Equalizer_init(void)
     // &BIQUAD_COEFF[0 * (NUMBER_OF_BIQUAD_STAGES * 5)] passes a pointer to the coefficients
     // for this specific band. We iterate the pointer by 15 for each bandpass filter
     // as each band has 3 stages * 5 coefficients = (NUMBER_OF_BIQUAD_STAGES * 5)
-    arm_biquad_cas_df1_32x64_init_q31(&B1, NUMBER_OF_BIQUAD_STAGES,
-                                      (q31_t*) &BIQUAD_COEFF[0 * (NUMBER_OF_BIQUAD_STAGES * 5)],
-                                      &biquadStateBand1Q31[0], COEFFICIENT_POSTSHIFT);
+    // The low bands take their coefficients from the table of the selected kernel
+    LOW_BAND_INIT(&B1, NUMBER_OF_BIQUAD_STAGES,
+                  (q31_t*) &LOW_BAND_COEFF[0 * (NUMBER_OF_BIQUAD_STAGES * LOW_BAND_COEFF_PER_STAGE)],
+                  &biquadStateBand1Q31[0], COEFFICIENT_POSTSHIFT);
     // Bandpass filter 2:
-    arm_biquad_cas_df1_32x64_init_q31(&B2, NUMBER_OF_BIQUAD_STAGES,
-                                      (q31_t*)&BIQUAD_COEFF[1 * (NUMBER_OF_BIQUAD_STAGES * 5)],
-                                      &biquadStateBand2Q31[0], COEFFICIENT_POSTSHIFT);
+    LOW_BAND_INIT(&B2, NUMBER_OF_BIQUAD_STAGES,
+                  (q31_t*) &LOW_BAND_COEFF[1 * (NUMBER_OF_BIQUAD_STAGES * LOW_BAND_COEFF_PER_STAGE)],
+                  &biquadStateBand2Q31[0], COEFFICIENT_POSTSHIFT);
 
     // Bandpass filter 3:
-    arm_biquad_cas_df1_32x64_init_q31(&B3, NUMBER_OF_BIQUAD_STAGES,
-                                      (q31_t*) &BIQUAD_COEFF[2 * (NUMBER_OF_BIQUAD_STAGES * 5)],
-                                      &biquadStateBand3Q31[0], COEFFICIENT_POSTSHIFT);
+    LOW_BAND_INIT(&B3, NUMBER_OF_BIQUAD_STAGES,
+                  (q31_t*) &LOW_BAND_COEFF[2 * (NUMBER_OF_BIQUAD_STAGES * LOW_BAND_COEFF_PER_STAGE)],
+                  &biquadStateBand3Q31[0], COEFFICIENT_POSTSHIFT);
 
     // Bandpass filter 4:
     arm_biquad_cascade_df1_init_q31(&B4, NUMBER_OF_BIQUAD_STAGES,
@@ -209,80 +943,2024 @@ static void ARM_Equalizer_init(void)
     arm_biquad_cascade_df1_init_q31(&B6, NUMBER_OF_BIQUAD_STAGES,
                                     (q31_t*) &BIQUAD_COEFF[5 * (NUMBER_OF_BIQUAD_STAGES * 5)],
                                     &biquadStateBand6Q31[0], COEFFICIENT_POSTSHIFT);
+
+    // Band gains of the mix, unity apart from the placeholder scale of band 1
+    for (uint32_t band = 0; band < NUMBER_OF_BANDS; band++)
+    {
+        bandMixGain[band] = GAIN_UNITY;
+    }
+    // SCALE HERE IF DESIRED
+    bandMixGain[0] = GAIN_UNITY << SCALE_FACTOR;
+    memcpy(bandGain, bandMixGain, sizeof(bandGain));
+
+    // Block floating point starts at the fixed 2^(-3) input scaling, so that the
+    // init can also restart a running equalizer
+    blockExponent = -HEADROOM_BITS;
+    blockBandPeak = 0;
+
+#if EQ_DYNAMICS
+    ARM_Equalizer_dynamics_init(SAMPLE_RATE_HZ);
+#endif
+
+#if EQ_MULTI_RATE
+    // Start on the table entry of SAMPLE_RATE_HZ rather than BIQUAD_COEFF
+    ARM_Equalizer_set_rate(SAMPLE_RATE_HZ);
+#endif
+
+#if SRC_ENABLED
+    // SRC: one prototype at SRC_INTERPOLATION times the stream rate serves both
+    // directions, its gain SRC_DECIMATION is what the interpolator needs
+    eq_src_design_q31(srcCoeffs, SRC_NUM_TAPS, SRC_COEFF_LENGTH,
+                      SRC_CUTOFF_HZ / ((float64_t) SAMPLE_RATE_HZ * SRC_DECIMATION), SRC_DECIMATION);
+#if (SRC_INTERPOLATION == 1)
+    arm_fir_decimate_init_q31(&srcDown, SRC_NUM_TAPS, SRC_DECIMATION, srcCoeffs,
+                              srcDownState, STREAM_SAMPLES_PER_TRANSFER);
+    arm_fir_interpolate_init_q31(&srcUp, SRC_DECIMATION, SRC_NUM_TAPS, srcCoeffs,
+                                 srcUpState, SAMPLES_PER_TRANSFER);
+#else
+    eq_fir_resample_init_q31(&srcDown, SRC_INTERPOLATION, SRC_DECIMATION, SRC_DOWN_PHASE_LENGTH, srcCoeffs,
+                             srcDownState, STREAM_SAMPLES_PER_TRANSFER);
+    eq_fir_resample_init_q31(&srcUp, SRC_DECIMATION, SRC_INTERPOLATION, SRC_SPAN, srcCoeffs,
+                             srcUpState, SAMPLES_PER_TRANSFER);
+#endif
+#endif
 }
 
 /**
  *******************************************************************************
  * @brief:     Apply the IIR filters using the ARM CMSIS DSP library and the SciPy
  *             Generated Q31 Coefficients that have been scaled
+ * @notes:     With a STREAM_SAMPLE_RATE_HZ other than SAMPLE_RATE_HZ the input is
+ *             resampled to the bank rate right after the conversion to Q31 and
+ *             the mix is resampled back right before the conversion to int16,
+ *             so the SRC only adds its filter passes. The blocksize then has to
+ *             be a multiple of SRC_DECIMATION (441 samples at 44.1 kHz).
  * @parameter: int16_t* pSrc      - Pointer to the source buffer
  *             int16_t* pDest     - Pointer to the destination buffer
- *             uint16_t blocksize - Number of samples to use in the filter
+ *             uint16_t blocksize - Number of samples to use in the filter, at
+ *                                  the stream rate
  * @return:    N/A
  *******************************************************************************
  */
 static void ARM_Equalizer(int16_t* pSrc, int16_t* pDest, uint16_t blocksize)
 {
-    // Convert pSrc to q31_t format (q15 works for int16)
-    arm_q15_to_q31(pSrc, q31Src, blocksize);
+    ARM_Equalizer_block(pSrc, pDest, blocksize, EQ_SAMPLES_Q15);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Same as ARM_Equalizer() for full scale int32 samples (Q31). The
+ *             engine works in Q31 anyway, so the samples go into the bank and
+ *             come out of the mix with all of their bits instead of the upper
+ *             16 of them.
+ * @parameter: const q31_t* pSrc   - Pointer to the source buffer
+ *             q31_t* pDest        - Pointer to the destination buffer, may be pSrc
+ *             uint16_t blocksize  - Number of samples to use in the filter, at
+ *                                   the stream rate
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_q31(const q31_t* pSrc, q31_t* pDest, uint16_t blocksize)
+{
+    ARM_Equalizer_block(pSrc, pDest, blocksize, EQ_SAMPLES_Q31);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Equalizes one block of either sample format, the body of
+ *             ARM_Equalizer() and ARM_Equalizer_q31(). The format is a constant
+ *             in both, so only the input and output conversions differ.
+ * @parameter: const void* pSrc    - Pointer to the source buffer
+ *             void* pDest         - Pointer to the destination buffer
+ *             uint16_t blocksize  - Number of samples at the stream rate
+ *             uint32_t format     - EQ_SAMPLES_Q15 or EQ_SAMPLES_Q31
+ * @return:    N/A
+ *******************************************************************************
+ */
+static inline void ARM_Equalizer_block(const void* pSrc, void* pDest, uint16_t blocksize, uint32_t format)
+{
+    // Block floating point: rather than always scaling the input down by 2^(-3),
+    // every block is scaled by 2^(exponent) so that its peak sits HEADROOM_BITS
+    // below full scale. Quiet blocks keep all of their bits through the filters.
+    EQ_PROFILE_BEGIN(profileBlock);
+    const int32_t exponent = (format == EQ_SAMPLES_Q31) ? ARM_Equalizer_exponent_q31(pSrc, blocksize) :
+                                                          ARM_Equalizer_exponent(pSrc, blocksize);
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_EXPONENT);
+#if SRC_ENABLED
+    const uint16_t bankBlocksize = (blocksize / SRC_DECIMATION) * SRC_INTERPOLATION;
+#else
+    const uint16_t bankBlocksize = blocksize;
+#endif
+
+    // Convert pSrc to q31_t format (q15 works for int16) and apply the exponent in
+    // the same pass, see ARM_Equalizer_convert
+    if (format == EQ_SAMPLES_Q31)
+    {
+        ARM_Equalizer_convert_q31(pSrc, exponent, blocksize);
+    }
+    else
+    {
+        ARM_Equalizer_convert(pSrc, exponent, blocksize);
+    }
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_CONVERT);
 
-    // Scale the input audio down to leave room for gain by a factor of -1/8 - 2^(-3)
-    // 0x7FFFFFFF represents the fractional portion of the scale value (this can be left as is)
-    arm_scale_q31(q31Src, 0x7FFFFFFF, -3, q31Src, blocksize);
+#if SRC_ENABLED
+    // Resample the stream down to the bank rate
+#if (SRC_INTERPOLATION == 1)
+    arm_fir_decimate_q31(&srcDown, q31Stream, q31Src, blocksize);
+#else
+    eq_fir_resample_q31(&srcDown, q31Stream, q31Src, blocksize);
+#endif
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_SRC_DOWN);
+#endif
 
     // Apply 6 bandpass filters using the two different versions
-    arm_biquad_cas_df1_32x64_q31(&B1, q31Src, outputB1, blocksize);
-    arm_biquad_cas_df1_32x64_q31(&B2, q31Src, outputB2, blocksize);
-    arm_biquad_cas_df1_32x64_q31(&B3, q31Src, outputB3, blocksize);
-    arm_biquad_cascade_df1_q31(&B4, q31Src, outputB4, blocksize);
-    arm_biquad_cascade_df1_q31(&B5, q31Src, outputB5, blocksize);
-    arm_biquad_cascade_df1_q31(&B6, q31Src, outputB6, blocksize);
+    LOW_BAND_FILTER(&B1, q31Src, outputB1, bankBlocksize);
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_BAND1 + 0);
+    LOW_BAND_FILTER(&B2, q31Src, outputB2, bankBlocksize);
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_BAND1 + 1);
+    LOW_BAND_FILTER(&B3, q31Src, outputB3, bankBlocksize);
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_BAND1 + 2);
+    arm_biquad_cascade_df1_q31(&B4, q31Src, outputB4, bankBlocksize);
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_BAND1 + 3);
+    arm_biquad_cascade_df1_q31(&B5, q31Src, outputB5, bankBlocksize);
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_BAND1 + 4);
+    arm_biquad_cascade_df1_q31(&B6, q31Src, outputB6, bankBlocksize);
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_BAND1 + 5);
+
+#if EQ_PRESETS
+    // Take over the band gains of a preset the control thread published meanwhile
+    ARM_Equalizer_preset_update();
+#endif
 
-    // Scale any one of the 6 bands, note this is not implemented...
-    // .. but rather just shows an example of how to equalize the audio
+    // Scale the 6 bands by their gains (bandMixGain, see ARM_Equalizer_init, and
+    // the dynamics if enabled), add them and scale the sum back by 2^(-exponent)
+    // to the original range, all in one pass
+    ARM_Equalizer_mix(exponent, bankBlocksize);
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_MIX);
+
+#if SRC_ENABLED
+    // Resample the mix back up to the stream rate
+#if (SRC_INTERPOLATION == 1)
+    arm_fir_interpolate_q31(&srcUp, q31Dest, q31Stream, bankBlocksize);
+#else
+    eq_fir_resample_q31(&srcUp, q31Dest, q31Stream, bankBlocksize);
+#endif
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_SRC_UP);
+
+    // Convert the stream to int16_t format (q15 works for int16), Q31 is copied
+    if (format == EQ_SAMPLES_Q31)
+    {
+        arm_copy_q31(q31Stream, pDest, blocksize);
+    }
+    else
     {
-	// SCALE HERE IF DESIRED
-	arm_scale_q31(outputB1, 0x7FFFFFFF, SCALE_FACTOR, outputB1, blocksize);
+        arm_q31_to_q15(q31Stream, pDest, blocksize);
     }
+#else
+    // Convert q31 Dest to int16_t format (q15 works for int16), Q31 is copied
+    if (format == EQ_SAMPLES_Q31)
+    {
+        arm_copy_q31(q31Dest, pDest, blocksize);
+    }
+    else
+    {
+        arm_q31_to_q15(q31Dest, pDest, blocksize);
+    }
+#endif
+    EQ_PROFILE_STAGE(profileBlock, EQ_PROFILE_OUTPUT);
+
+#if EQ_TELEMETRY
+    ARM_Equalizer_telemetry_publish(exponent);
+#endif
+#if EQ_METERING
+    ARM_Equalizer_meter_publish(exponent, bankBlocksize);
+#endif
+#if EQ_BAND_PEAKS
+    memset(blockBandPeaks, 0, sizeof(blockBandPeaks));
+#endif
+    EQ_PROFILE_END(profileBlock);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Picks the block floating point exponent of the next block. It is
+ *             the largest shift that keeps HEADROOM_BITS free above both the
+ *             input peak of this block and the band output peaks of the last
+ *             block (the filters still ring from it). The exponent drops at once
+ *             when the signal gets louder but only rises by one bit per block,
+ *             and the filter states are rescaled whenever it changes.
+ * @parameter: const int16_t* pSrc - Pointer to the source buffer
+ *             uint16_t blocksize  - Number of samples in the block
+ * @return:    int32_t - Exponent of the block, -HEADROOM_BITS..BLOCK_EXPONENT_MAX
+ *******************************************************************************
+ */
+static int32_t ARM_Equalizer_exponent(const int16_t* pSrc, uint16_t blocksize)
+{
+    q15_t inputPeak;
+    uint32_t index;
 
-    // Add corresponding elements of the 6 source buffers
-    arm_add_q31(outputB1, outputB2, q31Dest, blocksize);
-    arm_add_q31(q31Dest, outputB3, q31Dest, blocksize);
-    arm_add_q31(q31Dest, outputB4, q31Dest, blocksize);
-    arm_add_q31(q31Dest, outputB4, q31Dest, blocksize);
-    arm_add_q31(q31Dest, outputB6, q31Dest, blocksize);
+    // Redundant sign bits of the input peak once converted to Q31
+    arm_absmax_q15(pSrc, blocksize, &inputPeak, &index);
+
+    return ARM_Equalizer_exponent_update((int32_t) __CLZ((uint32_t) inputPeak << 16) - 1 - HEADROOM_BITS);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Same as ARM_Equalizer_exponent() for Q31 input samples
+ * @parameter: const q31_t* pSrc   - Pointer to the source buffer
+ *             uint16_t blocksize  - Number of samples in the block
+ * @return:    int32_t - Exponent of the block, -HEADROOM_BITS..BLOCK_EXPONENT_MAX
+ *******************************************************************************
+ */
+static int32_t ARM_Equalizer_exponent_q31(const q31_t* pSrc, uint16_t blocksize)
+{
+    q31_t inputPeak;
+    uint32_t index;
 
-    // Scale the output back up to the original range in Q31 format by a factor of 8 - 2^(3)
-    arm_scale_q31(q31Dest, 0x7FFFFFFF, 3, q31Dest, SAMPLES_PER_TRANSFER);
+    // Redundant sign bits of the input peak
+    arm_absmax_q31(pSrc, blocksize, &inputPeak, &index);
 
-    // Convert q31 Dest to int16_t format (q15 works for int16)
-    arm_q31_to_q15(q31Dest, pDest, SAMPLES_PER_TRANSFER);
+    return ARM_Equalizer_exponent_update((int32_t) __CLZ((uint32_t) inputPeak) - 1 - HEADROOM_BITS);
 }
 
 /**
  *******************************************************************************
- * @brief:     User custom data obtaining implemenation. This can be changed 
- * @parameter: int16_t* databuf - Pointer to the data buffer
+ * @brief:     Limits the exponent the input peak allows by the band outputs of
+ *             the last block and the rise of one bit per block, and rescales the
+ *             filter states when the exponent changes
+ * @parameter: int32_t exponent - Exponent allowed by the input peak
+ * @return:    int32_t - Exponent of the block, -HEADROOM_BITS..BLOCK_EXPONENT_MAX
+ *******************************************************************************
+ */
+static int32_t ARM_Equalizer_exponent_update(int32_t exponent)
+{
+    int32_t bandLimit;
+
+    // Same for the band outputs of the last block, relative to their exponent
+    bandLimit = blockExponent + (int32_t) __CLZ((uint32_t) blockBandPeak) - 1 - HEADROOM_BITS;
+    if (bandLimit < exponent)
+    {
+        exponent = bandLimit;
+    }
+
+    // Rise slowly, fall at once and stay within the supported range
+    if (exponent > blockExponent + 1)
+    {
+        exponent = blockExponent + 1;
+    }
+    if (exponent > BLOCK_EXPONENT_MAX)
+    {
+        exponent = BLOCK_EXPONENT_MAX;
+    }
+    if (exponent < -HEADROOM_BITS)
+    {
+        exponent = -HEADROOM_BITS;
+    }
+
+    if (exponent != blockExponent)
+    {
+        ARM_Equalizer_rescale(exponent - blockExponent);
+        blockExponent = exponent;
+    }
+
+    return exponent;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Converts the int16 input to Q31 and applies the block exponent in
+ *             the same pass, so it does the work of arm_q15_to_q31() and
+ *             arm_scale_q31() in one. The exponent is never below -HEADROOM_BITS,
+ *             so this is a left shift. With the SRC the input gain is applied
+ *             here as well, with the shift folded into its product, and the
+ *             result goes to q31Stream rather than q31Src.
+ * @parameter: const int16_t* pSrc - Pointer to the source buffer
+ *             int32_t exponent    - Exponent of the block
+ *             uint16_t blocksize  - Number of samples in the block
  * @return:    N/A
  *******************************************************************************
  */
-__attribute__((weak)) void user_custom_data_obtaining(int16_t* databuf)
+static void ARM_Equalizer_convert(const int16_t* pSrc, int32_t exponent, uint16_t blocksize)
 {
-    // Default weak implementation
-	UNUSED(databuf);
+#if SRC_ENABLED
+    q31_t* const pInput = q31Stream;
+#else
+    q31_t* const pInput = q31Src;
+#endif
+
+    for (uint32_t sample = 0; sample < blocksize; sample++)
+    {
+#if SRC_ENABLED
+        pInput[sample] = (q31_t) (((q63_t) pSrc[sample] * SRC_INPUT_GAIN) >> (15 - exponent));
+#else
+        pInput[sample] = (q31_t) pSrc[sample] << (16 + exponent);
+#endif
+#if EQ_TELEMETRY
+        blockSaturations[EQ_STAGE_INPUT] += (pSrc[sample] == INT16_MAX) | (pSrc[sample] == INT16_MIN);
+#endif
+    }
 }
 
 /**
  *******************************************************************************
- * @brief:     User custom data transfer implemenation. This can be changed 
- * @parameter: int16_t* databuf - Pointer to the data buffer
+ * @brief:     Same as ARM_Equalizer_convert() for Q31 input samples, which only
+ *             need the block exponent. A loud block (negative exponent) drops
+ *             the lowest bits, like the headroom of the int16 path does.
+ * @parameter: const q31_t* pSrc   - Pointer to the source buffer
+ *             int32_t exponent    - Exponent of the block
+ *             uint16_t blocksize  - Number of samples in the block
  * @return:    N/A
  *******************************************************************************
  */
-__attribute__((weak)) void user_custom_data_transfer(int16_t* databuf)
+static void ARM_Equalizer_convert_q31(const q31_t* pSrc, int32_t exponent, uint16_t blocksize)
 {
-    // Default weak implementation
-	UNUSED(databuf);
+#if SRC_ENABLED
+    q31_t* const pInput = q31Stream;
+#else
+    q31_t* const pInput = q31Src;
+#endif
+
+    for (uint32_t sample = 0; sample < blocksize; sample++)
+    {
+#if SRC_ENABLED
+        pInput[sample] = (q31_t) (((q63_t) pSrc[sample] * SRC_INPUT_GAIN) >> (31 - exponent));
+#else
+        pInput[sample] = (exponent >= 0) ? (pSrc[sample] << exponent) : (pSrc[sample] >> -exponent);
+#endif
+#if EQ_TELEMETRY
+        blockSaturations[EQ_STAGE_INPUT] += (pSrc[sample] == INT32_MAX) | (pSrc[sample] == INT32_MIN);
+#endif
+    }
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Rescales the state of every band filter by 2^(shift) so that the
+ *             past samples match the exponent of the next block. All the filter
+ *             structures are linear in their state, so this is exact apart from
+ *             the bits dropped by a right shift.
+ * @parameter: int32_t shift - Change of the block exponent
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_rescale(int32_t shift)
+{
+    uint32_t saturated = 0;
+
+    // Low bands, the state layout depends on the selected LOW_BAND_KERNEL
+#if (LOW_BAND_KERNEL == LOW_BAND_KERNEL_DF1_32X64)
+    saturated += eq_shift_state_q63(biquadStateBand1Q31, LOW_BAND_STATE_PER_STAGE * NUMBER_OF_BIQUAD_STAGES, shift);
+    saturated += eq_shift_state_q63(biquadStateBand2Q31, LOW_BAND_STATE_PER_STAGE * NUMBER_OF_BIQUAD_STAGES, shift);
+    saturated += eq_shift_state_q63(biquadStateBand3Q31, LOW_BAND_STATE_PER_STAGE * NUMBER_OF_BIQUAD_STAGES, shift);
+#else
+    saturated += eq_shift_state_q31(biquadStateBand1Q31, LOW_BAND_STATE_PER_STAGE * NUMBER_OF_BIQUAD_STAGES, shift);
+    saturated += eq_shift_state_q31(biquadStateBand2Q31, LOW_BAND_STATE_PER_STAGE * NUMBER_OF_BIQUAD_STAGES, shift);
+    saturated += eq_shift_state_q31(biquadStateBand3Q31, LOW_BAND_STATE_PER_STAGE * NUMBER_OF_BIQUAD_STAGES, shift);
+#endif
+
+    // High bands, 32x32 DF1
+    saturated += eq_shift_state_q31(biquadStateBand4Q31, 4 * NUMBER_OF_BIQUAD_STAGES, shift);
+    saturated += eq_shift_state_q31(biquadStateBand5Q31, 4 * NUMBER_OF_BIQUAD_STAGES, shift);
+    saturated += eq_shift_state_q31(biquadStateBand6Q31, 4 * NUMBER_OF_BIQUAD_STAGES, shift);
+
+#if SRC_ENABLED
+    // The input samples kept by the SRC decimator are at the exponent as well
+    saturated += eq_shift_state_q31(srcDownState, SRC_DOWN_PHASE_LENGTH - 1, shift);
+#endif
+
+#if EQ_TELEMETRY
+    blockSaturations[EQ_STAGE_RESCALE] += saturated;
+#else
+    UNUSED(saturated);
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Applies the band gains and adds the band outputs into q31Dest in a
+ *             single pass. The sum is kept in 64 bits so it cannot overflow
+ *             before the block exponent is removed, and is only saturated once
+ *             back at the original range. The leading bit of the band peaks is
+ *             tracked on the way for the exponent of the next block. With
+ *             EQ_DYNAMICS the block is mixed in sub-blocks of DYNAMICS_BLOCK
+ *             samples, the band peaks of every sub-block drive the gain computer
+ *             and the gains ramp towards its result over the next sub-block.
+ * @parameter: int32_t exponent   - Exponent of the block
+ *             uint16_t blocksize - Number of samples in the block
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_mix(int32_t exponent, uint16_t blocksize)
+{
+    q31_t bandPeak = 0;
+    uint32_t sample = 0;
+
+    while (sample < blocksize)
+    {
+#if EQ_DYNAMICS
+        const uint32_t end = (sample + DYNAMICS_BLOCK < blocksize) ? (sample + DYNAMICS_BLOCK) : blocksize;
+        q31_t subBlockPeaks[NUMBER_OF_BANDS] = { 0 };
+#else
+        const uint32_t end = blocksize;
+#endif
+
+        for (; sample < end; sample++)
+        {
+            q63_t sum = 0;
+
+            for (uint32_t band = 0; band < NUMBER_OF_BANDS; band++)
+            {
+                const q31_t value = outputBands[band][sample];
+                const q31_t magnitude = value ^ (value >> 31);
+
+                // OR-ing the one's complement magnitudes keeps the leading bit of the peak
+                sum += ((q63_t) value * bandGain[band]) >> GAIN_FRACTION_BITS;
+                bandPeak |= magnitude;
+#if EQ_DYNAMICS
+                subBlockPeaks[band] = (magnitude > subBlockPeaks[band]) ? magnitude : subBlockPeaks[band];
+                bandGain[band] += bandGainStep[band];
+#endif
+#if EQ_BAND_PEAKS
+                blockBandPeaks[band] = (magnitude > blockBandPeaks[band]) ? magnitude : blockBandPeaks[band];
+#endif
+#if EQ_METERING
+                // Sum of squares in Q46, which cannot overflow for any uint16_t blocksize
+                blockBandEnergy[band] += ((q63_t) value * value) >> 16;
+#endif
+            }
+
+            sum = (exponent >= 0) ? (sum >> exponent) : (sum << -exponent);
+#if EQ_TELEMETRY
+            blockSaturations[EQ_STAGE_MIX] += (sum != (q31_t) sum);
+#endif
+            q31Dest[sample] = clip_q63_to_q31(sum);
+        }
+
+#if EQ_DYNAMICS
+        ARM_Equalizer_dynamics(subBlockPeaks, exponent);
+#endif
+    }
+
+    blockBandPeak = bandPeak;
+}
+
+#if EQ_DYNAMICS
+/**
+ *******************************************************************************
+ * @brief:     Resets the multiband dynamics and sets the one pole envelope
+ *             coefficients for an update every DYNAMICS_BLOCK samples
+ * @parameter: uint32_t sampleRate - Sampling rate of the bank [Hz]
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_dynamics_init(uint32_t sampleRate)
+{
+    for (uint32_t band = 0; band < NUMBER_OF_BANDS; band++)
+    {
+        dynamicsAttack[band] = 1.0f - expf(-(float32_t) DYNAMICS_BLOCK * 1000.0f /
+                                           (DYNAMICS_PARAMS[band].attackMs * sampleRate));
+        dynamicsRelease[band] = 1.0f - expf(-(float32_t) DYNAMICS_BLOCK * 1000.0f /
+                                            (DYNAMICS_PARAMS[band].releaseMs * sampleRate));
+        dynamicsEnvelope[band] = 0.0f;
+        bandGainStep[band] = 0;
+    }
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Gain computer of the multiband dynamics, run once per sub-block
+ *             for all bands. The band peaks of the sub-block feed a one pole
+ *             attack/release envelope, the compressor and expander curves of
+ *             DYNAMICS_PARAMS turn its level into a gain, and the band gains
+ *             are set to ramp to the static band gain times that gain over the
+ *             next DYNAMICS_BLOCK samples.
+ * @parameter: const q31_t* pPeaks - Peak magnitude of every band in the sub-block
+ *             int32_t exponent    - Exponent of the block
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_dynamics(const q31_t* pPeaks, int32_t exponent)
+{
+    for (uint32_t band = 0; band < NUMBER_OF_BANDS; band++)
+    {
+        const eq_dynamics_params_t* pParams = &DYNAMICS_PARAMS[band];
+
+        // Peak relative to the int16 full scale, with the block exponent removed
+        const float32_t level = ldexpf((float32_t) pPeaks[band], -31 - exponent);
+        const float32_t coeff = (level > dynamicsEnvelope[band]) ? dynamicsAttack[band] : dynamicsRelease[band];
+        float32_t levelDb;
+        float32_t gainDb = pParams->makeupDb;
+        float32_t target;
+
+        dynamicsEnvelope[band] += (level - dynamicsEnvelope[band]) * coeff;
+        levelDb = 20.0f * log10f(dynamicsEnvelope[band] + 1e-9f);
+
+        if (levelDb > pParams->compThresholdDb)
+        {
+            gainDb += (1.0f / pParams->compRatio - 1.0f) * (levelDb - pParams->compThresholdDb);
+        }
+        else if (levelDb < pParams->expThresholdDb)
+        {
+            const float32_t expansion = (pParams->expRatio - 1.0f) * (levelDb - pParams->expThresholdDb);
+            gainDb += (expansion > DYNAMICS_FLOOR_DB) ? expansion : DYNAMICS_FLOOR_DB;
+        }
+
+        // Ramp from the current gain to the new one over the next sub-block
+        target = (float32_t) bandMixGain[band] * powf(10.0f, gainDb / 20.0f);
+        target = (target < DYNAMICS_GAIN_MAX) ? target : DYNAMICS_GAIN_MAX;
+        bandGainStep[band] = (q31_t) (((q63_t) target - bandGain[band]) >> DYNAMICS_BLOCK_SHIFT);
+    }
+}
+#endif
+
+#if EQ_PRESETS
+/**
+ *******************************************************************************
+ * @brief:     Applies a preset of band gains given in steps of the gain table of
+ *             Eq_ARM_gains.h (1 / EQ_GAIN_STEPS_PER_DB dB, 0 is 0 dB), e.g. one of
+ *             GAIN_PRESETS. The gains are looked up into a free slot and published
+ *             with a single atomic exchange, the audio thread takes them over at
+ *             its next block. Called from the control thread, it never waits for
+ *             the audio thread and nothing is computed apart from the lookups.
+ * @parameter: const int8_t* pSteps - Gain step of every band
+ * @return:    arm_status - ARM_MATH_ARGUMENT_ERROR if a step is outside of the
+ *                          table, in which case nothing is published
+ *******************************************************************************
+ */
+static arm_status ARM_Equalizer_apply_preset(const int8_t* pSteps)
+{
+    for (uint32_t band = 0; band < NUMBER_OF_BANDS; band++)
+    {
+        if ((pSteps[band] < EQ_GAIN_MIN_STEP) || (pSteps[band] > EQ_GAIN_MAX_STEP))
+        {
+            return ARM_MATH_ARGUMENT_ERROR;
+        }
+        presetGains[presetBack][band] = EQ_GAIN_TABLE[pSteps[band] - EQ_GAIN_MIN_STEP];
+    }
+
+    // Publish the filled slot and take over the one it replaces, which is either
+    // an older preset the audio thread has not picked up or the one it left
+    presetBack = atomic_exchange_explicit(&presetMiddle, presetBack | PRESET_FRESH, memory_order_acq_rel) &
+                 ~PRESET_FRESH;
+
+    return ARM_MATH_SUCCESS;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Takes over the band gains of the last published preset, if there
+ *             is a new one. Called by the audio thread once per block before the
+ *             mix. Without EQ_DYNAMICS the gains change at the block boundary,
+ *             with it they ramp there over the next sub-block.
+ * @parameter: N/A
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_preset_update(void)
+{
+    if ((atomic_load_explicit(&presetMiddle, memory_order_relaxed) & PRESET_FRESH) == 0)
+    {
+        return;
+    }
+
+    presetFront = atomic_exchange_explicit(&presetMiddle, presetFront, memory_order_acq_rel) & ~PRESET_FRESH;
+    memcpy(bandMixGain, presetGains[presetFront], sizeof(bandMixGain));
+#if !EQ_DYNAMICS
+    memcpy(bandGain, bandMixGain, sizeof(bandGain));
+#endif
+}
+#endif
+
+/**
+ *******************************************************************************
+ * @brief:     Shifts a Q31 filter state buffer by 2^(shift) with saturation
+ * @parameter: q31_t* pState  - Pointer to the state buffer
+ *             uint32_t count - Number of state variables
+ *             int32_t shift  - Left shift if positive, right shift if negative
+ * @return:    N/A
+ *******************************************************************************
+ */
+static uint32_t eq_shift_state_q31(q31_t* pState, uint32_t count, int32_t shift)
+{
+    uint32_t saturated = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (shift < 0)
+        {
+            pState[i] >>= -shift;
+        }
+        else
+        {
+            const q63_t value = (q63_t) pState[i] << shift;
+            saturated += (value != (q31_t) value);
+            pState[i] = clip_q63_to_q31(value);
+        }
+    }
+
+    return saturated;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Shifts a Q63 filter state buffer (arm_biquad_cas_df1_32x64_q31) by
+ *             2^(shift) with saturation
+ * @parameter: q63_t* pState  - Pointer to the state buffer
+ *             uint32_t count - Number of state variables
+ *             int32_t shift  - Left shift if positive, right shift if negative
+ * @return:    N/A
+ *******************************************************************************
+ */
+static uint32_t eq_shift_state_q63(q63_t* pState, uint32_t count, int32_t shift)
+{
+    uint32_t saturated = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (shift < 0)
+        {
+            pState[i] >>= -shift;
+        }
+        else if ((pState[i] << shift) >> shift == pState[i])
+        {
+            pState[i] <<= shift;
+        }
+        else
+        {
+            pState[i] = (pState[i] < 0) ? INT64_MIN : INT64_MAX;
+            saturated++;
+        }
+    }
+
+    return saturated;
+}
+
+#if EQ_TELEMETRY
+/**
+ *******************************************************************************
+ * @brief:     Publishes the saturation counts and band peaks of the block that
+ *             was just processed. The counters are plain variables during the
+ *             block and only touched atomically here, once per block.
+ * @parameter: int32_t exponent - Exponent of the block
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_telemetry_publish(int32_t exponent)
+{
+    for (uint32_t stage = 0; stage < EQ_STAGE_COUNT; stage++)
+    {
+        if (blockSaturations[stage] != 0)
+        {
+            atomic_fetch_add_explicit(&equalizerTelemetry.saturations[stage], blockSaturations[stage],
+                                      memory_order_relaxed);
+            blockSaturations[stage] = 0;
+        }
+    }
+
+    for (uint32_t band = 0; band < NUMBER_OF_BANDS; band++)
+    {
+        const q31_t peak = blockBandPeaks[band];
+        q31_t peakMax = atomic_load_explicit(&equalizerTelemetry.bandPeakMax[band], memory_order_relaxed);
+
+        atomic_store_explicit(&equalizerTelemetry.bandPeak[band], peak, memory_order_relaxed);
+
+        // Compare-and-swap so that a concurrent reset from the monitor is not lost
+        while ((peak > peakMax) &&
+               !atomic_compare_exchange_weak_explicit(&equalizerTelemetry.bandPeakMax[band], &peakMax, peak,
+                                                      memory_order_relaxed, memory_order_relaxed))
+        {
+        }
+    }
+
+    atomic_store_explicit(&equalizerTelemetry.exponent, exponent, memory_order_relaxed);
+    atomic_fetch_add_explicit(&equalizerTelemetry.blocks, 1U, memory_order_release);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Gives the monitoring thread access to the saturation telemetry.
+ *             The band peaks are the raw Q31 magnitudes inside the filters (at
+ *             the block exponent), i.e. how close the bands came to overflowing.
+ * @parameter: N/A
+ * @return:    const eq_telemetry_t* - Telemetry to read with atomic_load()
+ *******************************************************************************
+ */
+static const eq_telemetry_t* ARM_Equalizer_telemetry(void)
+{
+    return &equalizerTelemetry;
+}
+#endif
+
+#if EQ_METERING
+/**
+ *******************************************************************************
+ * @brief:     Turns the band energies and peaks gathered in the mix pass into
+ *             the published meters. The block exponent is removed first, then
+ *             the mean square is smoothed and the peak hold decays once per
+ *             block, so the per-sample cost stays at one multiply-accumulate
+ *             and one compare per band.
+ * @parameter: int32_t exponent   - Exponent of the block
+ *             uint16_t blocksize - Number of samples in the block
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_meter_publish(int32_t exponent, uint16_t blocksize)
+{
+    for (uint32_t band = 0; band < NUMBER_OF_BANDS; band++)
+    {
+        q63_t meanSquare = (blocksize != 0) ? (blockBandEnergy[band] / blocksize) : 0;
+        q31_t peak = blockBandPeaks[band];
+
+        // Back to the int16 full scale, the mean square scales with 2^(2 * exponent)
+        meanSquare = (exponent >= 0) ? (meanSquare >> (2 * exponent)) : (meanSquare << (-2 * exponent));
+        peak = (exponent >= 0) ? (peak >> exponent) : clip_q63_to_q31((q63_t) peak << -exponent);
+
+        meterMeanSquare[band] += (meanSquare - meterMeanSquare[band]) >> METER_SMOOTHING_SHIFT;
+        meterPeak[band] -= meterPeak[band] >> METER_PEAK_DECAY_SHIFT;
+        meterPeak[band] = (peak > meterPeak[band]) ? peak : meterPeak[band];
+
+        atomic_store_explicit(&equalizerMeters.rms[band], eq_sqrt_q63(meterMeanSquare[band] << 16),
+                              memory_order_relaxed);
+        atomic_store_explicit(&equalizerMeters.peak[band], meterPeak[band], memory_order_relaxed);
+
+        blockBandEnergy[band] = 0;
+    }
+
+    atomic_fetch_add_explicit(&equalizerMeters.sequence, 1U, memory_order_release);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Gives the dashboard access to the per-band level meters
+ * @parameter: N/A
+ * @return:    const eq_meter_t* - Meters to read with atomic_load()
+ *******************************************************************************
+ */
+static const eq_meter_t* ARM_Equalizer_meters(void)
+{
+    return &equalizerMeters;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Integer square root of a non-negative Q62 value, giving Q31. Only
+ *             called once per band and block, so a bitwise version is used.
+ * @parameter: q63_t value - Value to take the square root of, 0..2^62
+ * @return:    q31_t - Square root rounded down
+ *******************************************************************************
+ */
+static q31_t eq_sqrt_q63(q63_t value)
+{
+    uint64_t remainder = (uint64_t) value;
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t) 1 << 62;
+
+    while (bit > remainder)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (remainder >= root + bit)
+        {
+            remainder -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (root > INT32_MAX) ? INT32_MAX : (q31_t) root;
+}
+#endif
+
+#if EQ_PROFILE
+/**
+ *******************************************************************************
+ * @brief:     Reads the cycle counter selected by EQ_PROFILE_CLOCK. Only the
+ *             difference of two reads is used, so a wrap of the 32 bits is fine
+ *             as long as a call takes fewer than 2^32 cycles. The perf_event
+ *             counter is read with rdpmc through its user page where the kernel
+ *             allows it (x86, kernel.perf_rdpmc), a few ns rather than the
+ *             microsecond of a read() per stage, which remains the fallback.
+ * @parameter: N/A
+ * @return:    uint32_t - Cycle count
+ *******************************************************************************
+ */
+static uint32_t eq_profile_cycles(void)
+{
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_DWT)
+    return EQ_DWT_CYCCNT;
+#elif (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_RDTSC)
+    return (uint32_t) __rdtsc();
+#else
+    uint64_t count = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    const volatile struct perf_event_mmap_page* const pPage = pThreadCounterPage;
+
+    if (pPage != NULL)
+    {
+        uint32_t lock;
+        uint32_t index;
+
+        // Retry while the kernel updates the page, e.g. when the thread migrated
+        do
+        {
+            lock = pPage->lock;
+            atomic_signal_fence(memory_order_seq_cst);
+            index = pPage->cap_user_rdpmc ? pPage->index : 0;
+            count = (uint64_t) pPage->offset;
+            if (index != 0)
+            {
+                const uint32_t shift = 64 - pPage->pmc_width;
+
+                count += (uint64_t) ((int64_t) ((uint64_t) __rdpmc((int) index - 1) << shift) >> shift);
+            }
+            atomic_signal_fence(memory_order_seq_cst);
+        } while (pPage->lock != lock);
+
+        // Not on a hardware counter right now, read() has the count then
+        if (index != 0)
+        {
+            return (uint32_t) count;
+        }
+    }
+#endif
+
+    if ((threadCycleCounter < 0) || (read(threadCycleCounter, &count, sizeof(count)) != sizeof(count)))
+    {
+        return 0;
+    }
+
+    return (uint32_t) count;
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Claims the histograms of the calling thread and starts its cycle
+ *             counter. A compare-and-swap hands out the slots, so threads never
+ *             wait on each other; threads beyond EQ_PROFILE_THREADS running at
+ *             the same time go untimed. On the host the slot and the counter
+ *             are released again when the thread exits, see eq_profile_release.
+ * @parameter: N/A
+ * @return:    eq_profile_t* - Histograms of the thread, NULL if none is left
+ *******************************************************************************
+ */
+static eq_profile_t* eq_profile_claim(void)
+{
+    uint32_t claimed = atomic_load_explicit(&profileSlotsClaimed, memory_order_relaxed);
+    uint32_t slot;
+
+    do
+    {
+        const uint32_t free = ~claimed & EQ_PROFILE_SLOTS_ALL;
+
+        if (free == 0)
+        {
+            return NULL;
+        }
+        slot = 31 - __CLZ(free & (0U - free));
+    } while (!atomic_compare_exchange_weak_explicit(&profileSlotsClaimed, &claimed, claimed | (1U << slot),
+                                                    memory_order_acquire, memory_order_relaxed));
+    atomic_fetch_or_explicit(&profileSlotsTimed, 1U << slot, memory_order_release);
+
+#if (EQ_PROFILE_CLOCK != EQ_PROFILE_CLOCK_DWT)
+    // Hand the slot back at thread exit, the main thread keeps it until the end
+    pthread_once(&profileKeyOnce, eq_profile_key_create);
+    if (profileKeyCreated)
+    {
+        pthread_setspecific(profileKey, &profileThreads[slot]);
+    }
+#endif
+
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_DWT)
+    // Enable the trace block and the cycle counter of the DWT
+    EQ_DEMCR |= EQ_DEMCR_TRCENA;
+    EQ_DWT_CTRL |= EQ_DWT_CTRL_CYCCNTENA;
+#elif (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_PERF)
+    // User space cycles of this thread on whatever CPU it runs
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    threadCycleCounter = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#if defined(__x86_64__) || defined(__i386__)
+    // User page of the counter, for rdpmc in eq_profile_cycles
+    if (threadCycleCounter >= 0)
+    {
+        void* const pPage = mmap(NULL, (size_t) sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, threadCycleCounter, 0);
+
+        pThreadCounterPage = (pPage != MAP_FAILED) ? pPage : NULL;
+    }
+#endif
+#endif
+
+    return &profileThreads[slot];
+}
+
+#if (EQ_PROFILE_CLOCK != EQ_PROFILE_CLOCK_DWT)
+/**
+ *******************************************************************************
+ * @brief:     Creates the thread-specific key that releases the slots, once
+ * @parameter: N/A
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_profile_key_create(void)
+{
+    profileKeyCreated = (pthread_key_create(&profileKey, eq_profile_release) == 0);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Releases the slot of a thread when it exits, called by pthreads.
+ *             The perf_event counter is closed and the slot is handed to the
+ *             next thread that claims one; its histograms stay and keep adding
+ *             up, so ARM_Equalizer_profile still reports the exited threads.
+ * @parameter: void* pProfile - Histograms of the exiting thread
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_profile_release(void* pProfile)
+{
+    const uint32_t slot = (uint32_t) ((eq_profile_t*) pProfile - profileThreads);
+
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_PERF)
+    if (pThreadCounterPage != NULL)
+    {
+        munmap((void*) pThreadCounterPage, (size_t) sysconf(_SC_PAGESIZE));
+        pThreadCounterPage = NULL;
+    }
+    if (threadCycleCounter >= 0)
+    {
+        close(threadCycleCounter);
+        threadCycleCounter = -1;
+    }
+#endif
+
+    pThreadProfile = NULL;
+    atomic_fetch_and_explicit(&profileSlotsClaimed, ~(1U << slot), memory_order_release);
+}
+#endif
+
+/**
+ *******************************************************************************
+ * @brief:     Starts timing a call of ARM_Equalizer
+ * @parameter: eq_profile_block_t* pBlock - Timestamps of the call
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_profile_begin(eq_profile_block_t* pBlock)
+{
+    if (pThreadProfile == NULL)
+    {
+        pThreadProfile = eq_profile_claim();
+    }
+
+    pBlock->pProfile = pThreadProfile;
+    pBlock->timed = 0;
+    pBlock->start = eq_profile_cycles();
+    pBlock->last = pBlock->start;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Ends a stage, which is charged the cycles since the last one ended
+ * @parameter: eq_profile_block_t* pBlock - Timestamps of the call
+ *             uint32_t stage             - EQ_PROFILE_ stage that just ended
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_profile_stage(eq_profile_block_t* pBlock, uint32_t stage)
+{
+    const uint32_t now = eq_profile_cycles();
+
+    pBlock->cycles[stage] = now - pBlock->last;
+    pBlock->last = now;
+    pBlock->timed |= 1U << stage;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Ends the call and adds its stages to the histograms of the thread.
+ *             The sequence is odd while they are written, see eq_profile_t.
+ * @parameter: eq_profile_block_t* pBlock - Timestamps of the call
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_profile_end(eq_profile_block_t* pBlock)
+{
+    eq_profile_t* const pProfile = pBlock->pProfile;
+    uint32_t sequence;
+
+    pBlock->cycles[EQ_PROFILE_TOTAL] = eq_profile_cycles() - pBlock->start;
+    pBlock->timed |= 1U << EQ_PROFILE_TOTAL;
+    if (pProfile == NULL)
+    {
+        return;
+    }
+
+    sequence = atomic_load_explicit(&pProfile->sequence, memory_order_relaxed);
+    atomic_store_explicit(&pProfile->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (uint32_t stage = 0; stage < EQ_PROFILE_STAGE_COUNT; stage++)
+    {
+        eq_profile_histogram_t* const pStage = &pProfile->stages[stage];
+        const uint32_t cycles = pBlock->cycles[stage];
+
+        if ((pBlock->timed & (1U << stage)) == 0)
+        {
+            continue;
+        }
+
+        pStage->min = ((pStage->count == 0) || (cycles < pStage->min)) ? cycles : pStage->min;
+        pStage->max = (cycles > pStage->max) ? cycles : pStage->max;
+        pStage->sum += cycles;
+        pStage->count++;
+        pStage->buckets[(cycles > 1) ? (31 - __CLZ(cycles)) : 0]++;
+    }
+
+    atomic_store_explicit(&pProfile->sequence, sequence + 2, memory_order_release);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Adds up the cycle histograms of all threads, e.g. for a monitoring
+ *             thread. The histograms only ever grow, the cycles of an interval
+ *             are the difference of two reads.
+ * @parameter: eq_profile_histogram_t* pStages - EQ_PROFILE_STAGE_COUNT histograms
+ *                                               to fill, indexed by EQ_PROFILE_ stage
+ * @return:    uint32_t - Number of slots that were timed, a slot holds the
+ *                        threads that claimed it one after the other
+ *******************************************************************************
+ */
+static uint32_t ARM_Equalizer_profile(eq_profile_histogram_t* pStages)
+{
+    const uint32_t timed = atomic_load_explicit(&profileSlotsTimed, memory_order_acquire);
+    uint32_t threads = 0;
+    eq_profile_histogram_t copy[EQ_PROFILE_STAGE_COUNT];
+
+    memset(pStages, 0, EQ_PROFILE_STAGE_COUNT * sizeof(eq_profile_histogram_t));
+
+    for (uint32_t thread = 0; thread < EQ_PROFILE_THREADS; thread++)
+    {
+        eq_profile_t* const pProfile = &profileThreads[thread];
+        uint32_t sequence;
+
+        if ((timed & (1U << thread)) == 0)
+        {
+            continue;
+        }
+        threads++;
+
+        // Copy again until no block was added meanwhile
+        do
+        {
+            sequence = atomic_load_explicit(&pProfile->sequence, memory_order_acquire);
+            memcpy(copy, pProfile->stages, sizeof(copy));
+            atomic_thread_fence(memory_order_acquire);
+        } while (((sequence & 1U) != 0) ||
+                 (sequence != atomic_load_explicit(&pProfile->sequence, memory_order_relaxed)));
+
+        for (uint32_t stage = 0; stage < EQ_PROFILE_STAGE_COUNT; stage++)
+        {
+            if (copy[stage].count == 0)
+            {
+                continue;
+            }
+            pStages[stage].min = ((pStages[stage].count == 0) || (copy[stage].min < pStages[stage].min)) ?
+                                 copy[stage].min : pStages[stage].min;
+            pStages[stage].max = (copy[stage].max > pStages[stage].max) ? copy[stage].max : pStages[stage].max;
+            pStages[stage].sum += copy[stage].sum;
+            pStages[stage].count += copy[stage].count;
+            for (uint32_t bucket = 0; bucket < EQ_PROFILE_BUCKETS; bucket++)
+            {
+                pStages[stage].buckets[bucket] += copy[stage].buckets[bucket];
+            }
+        }
+    }
+
+    return threads;
+}
+#endif
+
+#if EQ_LATENCY
+/**
+ *******************************************************************************
+ * @brief:     Clears the latency histograms and starts the clock
+ * @parameter: N/A
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_latency_init(void)
+{
+    memset(latencyHistograms, 0, sizeof(latencyHistograms));
+    atomic_store_explicit(&latencyExportRequest, 0U, memory_order_relaxed);
+    atomic_store_explicit(&latencyRunning, 1U, memory_order_relaxed);
+
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_DWT)
+    // Enable the trace block and the cycle counter of the DWT
+    EQ_DEMCR |= EQ_DEMCR_TRCENA;
+    EQ_DWT_CTRL |= EQ_DWT_CTRL_CYCCNTENA;
+    latencyCycleLast = EQ_DWT_CYCCNT;
+    latencyCycleHigh = 0;
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Reads the latency clock, see EQ_LATENCY_TICK_HZ. The 32-bit DWT
+ *             count is extended on the way, which only needs one read per wrap
+ *             (25 s at 168 MHz) and the driver loop reads it three times a block.
+ * @parameter: N/A
+ * @return:    uint64_t - Time [ticks]
+ *******************************************************************************
+ */
+static uint64_t eq_latency_now(void)
+{
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_DWT)
+    const uint32_t cycles = EQ_DWT_CYCCNT;
+
+    if (cycles < latencyCycleLast)
+    {
+        latencyCycleHigh += (uint64_t) 1 << 32;
+    }
+    latencyCycleLast = cycles;
+
+    return latencyCycleHigh | cycles;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000U + (uint64_t) now.tv_nsec;
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Extends a capture time stamp to the latency clock. With the DWT
+ *             only its lower 32 bits are used, the raw CYCCNT an ISR can read,
+ *             and it is placed within the last wrap of the counter.
+ * @parameter: uint64_t stamp - Capture time [ticks]
+ * @return:    uint64_t - Capture time on the clock of eq_latency_now() [ticks]
+ *******************************************************************************
+ */
+static uint64_t eq_latency_extend(uint64_t stamp)
+{
+#if (EQ_PROFILE_CLOCK == EQ_PROFILE_CLOCK_DWT)
+    const uint64_t now = eq_latency_now();
+
+    return now - (uint32_t) ((uint32_t) now - (uint32_t) stamp);
+#else
+    return stamp;
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Sub-bucket of a latency. The first EQ_LATENCY_HALF * 2 ticks have
+ *             a sub-bucket each, above that every power of two adds another
+ *             EQ_LATENCY_HALF sub-buckets of 2^(magnitude) ticks.
+ * @parameter: uint64_t ticks - Latency
+ * @return:    uint32_t - Index into eq_latency_histogram_t.buckets
+ *******************************************************************************
+ */
+static uint32_t eq_latency_index(uint64_t ticks)
+{
+    uint32_t magnitude = 0;
+
+    if (ticks >= ((uint64_t) 1 << EQ_LATENCY_RANGE_BITS))
+    {
+        ticks = ((uint64_t) 1 << EQ_LATENCY_RANGE_BITS) - 1;
+    }
+    if (ticks >= (2U * EQ_LATENCY_HALF))
+    {
+        magnitude = (uint32_t) (63 - __builtin_clzll(ticks)) - (EQ_LATENCY_SUB_BITS - 1);
+    }
+
+    return magnitude * EQ_LATENCY_HALF + (uint32_t) (ticks >> magnitude);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Records the latencies of one block of the driver loop
+ * @parameter: uint64_t captured    - Time the block was captured [ticks]
+ *             uint64_t equalized   - Time ARM_Equalizer was done with it
+ *             uint64_t transferred - Time its transfer was done
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_latency_record(uint64_t captured, uint64_t equalized, uint64_t transferred)
+{
+    const uint64_t latencies[EQ_LATENCY_COUNT] =
+    {
+        equalized - captured, transferred - equalized, transferred - captured
+    };
+
+    for (uint32_t interval = 0; interval < EQ_LATENCY_COUNT; interval++)
+    {
+        eq_latency_histogram_t* const pHistogram = &latencyHistograms[interval];
+
+        pHistogram->buckets[eq_latency_index(latencies[interval])]++;
+        pHistogram->max = (latencies[interval] > pHistogram->max) ? latencies[interval] : pHistogram->max;
+        pHistogram->count++;
+    }
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Writes the p50, p99, p99.9 and max latencies of every interval as
+ *             one line of JSON, in microseconds. A percentile is the upper end
+ *             of the sub-bucket it falls in, like HdrHistogram reports it.
+ * @parameter: FILE* pFile - Where to write the latencies
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_latency_export(FILE* pFile)
+{
+    static const char* const intervals[EQ_LATENCY_COUNT] = { "capture_to_eq", "eq_to_transfer", "capture_to_transfer" };
+    static const char* const names[] = { "p50", "p99", "p99_9" };
+    static const float64_t quantiles[] = { 0.5, 0.99, 0.999 };
+    const float64_t microseconds = 1e6 / EQ_LATENCY_TICK_HZ;
+
+    fprintf(pFile, "{\"latency_us\": {");
+    for (uint32_t interval = 0; interval < EQ_LATENCY_COUNT; interval++)
+    {
+        const eq_latency_histogram_t* const pHistogram = &latencyHistograms[interval];
+        uint64_t seen = 0;
+        uint32_t index = 0;
+
+        fprintf(pFile, "%s\"%s\": {\"blocks\": %llu", (interval > 0) ? ", " : "", intervals[interval],
+                (unsigned long long) pHistogram->count);
+
+        // The quantiles rise, so one walk over the buckets finds all of them
+        for (uint32_t quantile = 0; quantile < sizeof(quantiles) / sizeof(quantiles[0]); quantile++)
+        {
+            const uint64_t rank = (uint64_t) ceil(quantiles[quantile] * (float64_t) pHistogram->count);
+            uint64_t upper;
+
+            while ((seen < rank) && (index < EQ_LATENCY_BUCKETS))
+            {
+                seen += pHistogram->buckets[index++];
+            }
+            if (index == 0)
+            {
+                upper = 0;
+            }
+            else if ((index - 1) < (2U * EQ_LATENCY_HALF))
+            {
+                upper = index - 1;
+            }
+            else
+            {
+                const uint32_t magnitude = (index - 1) / EQ_LATENCY_HALF - 1;
+                const uint64_t sub = (index - 1) - magnitude * EQ_LATENCY_HALF;
+
+                upper = ((sub + 1) << magnitude) - 1;
+            }
+            upper = (upper < pHistogram->max) ? upper : pHistogram->max;
+            fprintf(pFile, ", \"%s\": %.1f", names[quantile], upper * microseconds);
+        }
+        fprintf(pFile, ", \"max\": %.1f}", pHistogram->max * microseconds);
+    }
+    fprintf(pFile, "}}\n");
+    fflush(pFile);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Asks the driver loop to export the latencies after the current
+ *             block. Safe from any thread, interrupt or signal handler.
+ * @parameter: N/A
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_latency_request(void)
+{
+    atomic_store_explicit(&latencyExportRequest, 1U, memory_order_relaxed);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Ends the driver loop after the current block, which then exports
+ *             the latencies of the whole run. Safe from any thread, interrupt or
+ *             signal handler.
+ * @parameter: N/A
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void ARM_Equalizer_latency_shutdown(void)
+{
+    atomic_store_explicit(&latencyRunning, 0U, memory_order_relaxed);
+}
+
+#if !EQ_NO_MAIN && defined(__unix__) && (EQ_PROFILE_CLOCK != EQ_PROFILE_CLOCK_DWT)
+/**
+ *******************************************************************************
+ * @brief:     Signal handler of the driver loop, SIGUSR1 exports the latencies
+ *             and any other signal shuts the loop down
+ * @parameter: int signalNumber - Number of the signal
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_latency_signal(int signalNumber)
+{
+    if (signalNumber == SIGUSR1)
+    {
+        ARM_Equalizer_latency_request();
+    }
+    else
+    {
+        ARM_Equalizer_latency_shutdown();
+    }
+}
+#endif
+#endif
+
+/**
+ *******************************************************************************
+ * @brief:     Inits the Q31 Biquad cascade with error feedback
+ * @parameter: eq_biquad_cas_df1_ef_ins_q31* S - Points to the instance
+ *             uint8_t numStages               - Number of 2nd order stages
+ *             const q31_t* pCoeffs            - Points to the coefficients, same
+ *                                               {b0, b1, b2, a1, a2} layout as CMSIS
+ *             q31_t* pState                   - Points to the state buffer of
+ *                                               size 5 * numStages
+ *             uint8_t postShift               - Shift applied to the accumulator
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_biquad_cas_df1_ef_init_q31(eq_biquad_cas_df1_ef_ins_q31* S, uint8_t numStages,
+                                          const q31_t* pCoeffs, q31_t* pState, uint8_t postShift)
+{
+    S->numStages = numStages;
+    S->pCoeffs = pCoeffs;
+    S->pState = pState;
+    S->postShift = postShift;
+
+    // Clear the past inputs, outputs and the stored truncation error
+    memset(pState, 0, 5U * numStages * sizeof(q31_t));
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Q31 Direct Form I Biquad cascade with first order error feedback.
+ *             The arithmetic is the same as arm_biquad_cascade_df1_q31()
+ *             (32x32-bit products into a 64-bit accumulator), but the bits
+ *             truncated when converting the accumulator back to 1.31 are kept
+ *             and added into the next sample's accumulator. This places a zero
+ *             at DC in the noise transfer function, cancelling most of the
+ *             noise gain of poles close to z = 1, which is what the low bands
+ *             otherwise need the 64-bit state of arm_biquad_cas_df1_32x64_q31
+ *             for. The cost over the plain 32x32 kernel is one add and one mask
+ *             per sample and stage.
+ * @parameter: const eq_biquad_cas_df1_ef_ins_q31* S - Points to the instance
+ *             const q31_t* pSrc  - Pointer to the source buffer
+ *             q31_t* pDst        - Pointer to the destination buffer
+ *             uint32_t blockSize - Number of samples to process
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_biquad_cas_df1_ef_q31(const eq_biquad_cas_df1_ef_ins_q31* S, const q31_t* pSrc,
+                                     q31_t* pDst, uint32_t blockSize)
+{
+    const q31_t* pIn = pSrc;
+    const q31_t* pCoeffs = S->pCoeffs;
+    q31_t* pState = S->pState;
+    q31_t* pOut;
+
+    // Shift to convert the 2.62 accumulator back to 1.31 and mask of the bits it drops
+    const uint32_t lShift = 31U - S->postShift;
+    const q63_t errMask = ((q63_t) 1 << lShift) - 1;
+
+    uint32_t stage = S->numStages;
+
+    do
+    {
+        // Coefficients and state of this stage
+        const q31_t b0 = pCoeffs[0];
+        const q31_t b1 = pCoeffs[1];
+        const q31_t b2 = pCoeffs[2];
+        const q31_t a1 = pCoeffs[3];
+        const q31_t a2 = pCoeffs[4];
+
+        q31_t Xn1 = pState[0];
+        q31_t Xn2 = pState[1];
+        q31_t Yn1 = pState[2];
+        q31_t Yn2 = pState[3];
+        q31_t err = pState[4];
+
+        pOut = pDst;
+
+        for (uint32_t sample = 0; sample < blockSize; sample++)
+        {
+            const q31_t Xn = *pIn++;
+
+            // acc = e[n-1] + b0 * x[n] + b1 * x[n-1] + b2 * x[n-2] + a1 * y[n-1] + a2 * y[n-2]
+            q63_t acc = (q63_t) err;
+            acc += (q63_t) b0 * Xn;
+            acc += (q63_t) b1 * Xn1;
+            acc += (q63_t) b2 * Xn2;
+            acc += (q63_t) a1 * Yn1;
+            acc += (q63_t) a2 * Yn2;
+
+            // Keep the truncated fraction (always positive) for the next sample
+            err = (q31_t) (acc & errMask);
+
+            Xn2 = Xn1;
+            Xn1 = Xn;
+            Yn2 = Yn1;
+            Yn1 = (q31_t) (acc >> lShift);
+
+            *pOut++ = Yn1;
+        }
+
+        // The output of this stage is the input of the next one
+        pIn = pDst;
+        pCoeffs += 5;
+
+        pState[0] = Xn1;
+        pState[1] = Xn2;
+        pState[2] = Yn1;
+        pState[3] = Yn2;
+        pState[4] = err;
+        pState += 5;
+
+    } while (--stage);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Inits the Q31 coupled-form Biquad cascade
+ * @parameter: eq_biquad_cas_coupled_ins_q31* S - Points to the instance
+ *             uint8_t numStages                - Number of 2nd order stages
+ *             const q31_t* pCoeffs             - Points to the {d, g, cr, ci, c1, c2}
+ *                                                coefficients of every stage as
+ *                                                printed by Eq_SciPy_ARM.py
+ *             q31_t* pState                    - Points to the state buffer of
+ *                                                size 2 * numStages
+ *             uint8_t postShift                - Shift applied to the accumulator
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_biquad_cas_coupled_init_q31(eq_biquad_cas_coupled_ins_q31* S, uint8_t numStages,
+                                           const q31_t* pCoeffs, q31_t* pState, uint8_t postShift)
+{
+    S->numStages = numStages;
+    S->pCoeffs = pCoeffs;
+    S->pState = pState;
+    S->postShift = postShift;
+
+    // Clear the two state variables of every stage
+    memset(pState, 0, 2U * numStages * sizeof(q31_t));
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Q31 coupled-form (normal form, Gold-Rader) Biquad cascade. Each
+ *             stage is the state-space section
+ *                 y[n]    = d * x[n] + c1 * v1[n] + c2 * v2[n]
+ *                 v1[n+1] = cr * v1[n] - ci * v2[n] + g * x[n]
+ *                 v2[n+1] = ci * v1[n] + cr * v2[n]
+ *             with the pole cr + j*ci stored directly. The DF1 a1 and a2
+ *             coefficients get very coarse for poles close to z = 1, while the
+ *             coupled form quantizes the poles on a uniform grid, so the
+ *             narrow low bands can run on 32-bit state. It costs 8 instead of 5
+ *             multiplies per sample and stage, but needs only 2 state words.
+ * @parameter: const eq_biquad_cas_coupled_ins_q31* S - Points to the instance
+ *             const q31_t* pSrc  - Pointer to the source buffer
+ *             q31_t* pDst        - Pointer to the destination buffer
+ *             uint32_t blockSize - Number of samples to process
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_biquad_cas_coupled_q31(const eq_biquad_cas_coupled_ins_q31* S, const q31_t* pSrc,
+                                      q31_t* pDst, uint32_t blockSize)
+{
+    const q31_t* pIn = pSrc;
+    const q31_t* pCoeffs = S->pCoeffs;
+    q31_t* pState = S->pState;
+    q31_t* pOut;
+
+    // Shift to convert the 2.62 accumulators back to 1.31
+    const uint32_t lShift = 31U - S->postShift;
+
+    uint32_t stage = S->numStages;
+
+    do
+    {
+        // Coefficients and state of this stage
+        const q31_t d  = pCoeffs[0];
+        const q31_t g  = pCoeffs[1];
+        const q31_t cr = pCoeffs[2];
+        const q31_t ci = pCoeffs[3];
+        const q31_t c1 = pCoeffs[4];
+        const q31_t c2 = pCoeffs[5];
+
+        q31_t v1 = pState[0];
+        q31_t v2 = pState[1];
+
+        pOut = pDst;
+
+        for (uint32_t sample = 0; sample < blockSize; sample++)
+        {
+            const q31_t Xn = *pIn++;
+
+            // y[n] = d * x[n] + c1 * v1[n] + c2 * v2[n]
+            q63_t acc = (q63_t) d * Xn;
+            acc += (q63_t) c1 * v1;
+            acc += (q63_t) c2 * v2;
+
+            // Rotate the state by the pole and feed in the input
+            q63_t acc1 = (q63_t) cr * v1;
+            acc1 -= (q63_t) ci * v2;
+            acc1 += (q63_t) g * Xn;
+
+            q63_t acc2 = (q63_t) ci * v1;
+            acc2 += (q63_t) cr * v2;
+
+            v1 = (q31_t) (acc1 >> lShift);
+            v2 = (q31_t) (acc2 >> lShift);
+
+            *pOut++ = (q31_t) (acc >> lShift);
+        }
+
+        // The output of this stage is the input of the next one
+        pIn = pDst;
+        pCoeffs += 6;
+
+        pState[0] = v1;
+        pState[1] = v2;
+        pState += 2;
+
+    } while (--stage);
+}
+
+#if EQ_MULTI_RATE
+/**
+ *******************************************************************************
+ * @brief:     Switches the bank to another sampling rate by pointing the filter
+ *             instances at its entry of the packed tables in Eq_ARM_coeffs.h,
+ *             nothing is designed at runtime. The filter states are cleared as
+ *             they belong to the old rate. Call it between two blocks, from the
+ *             thread that runs ARM_Equalizer().
+ * @parameter: uint32_t sampleRate - New sampling rate [Hz], one of EQ_RATE_HZ
+ * @return:    arm_status - ARM_MATH_ARGUMENT_ERROR if the rate is not in the
+ *                          table, in which case nothing is changed
+ *******************************************************************************
+ */
+static arm_status ARM_Equalizer_set_rate(uint32_t sampleRate)
+{
+    const q31_t* pLowCoeffs;
+    const q31_t* pHighCoeffs;
+    uint32_t rate = 0;
+
+    while ((rate < EQ_RATE_COUNT) && (EQ_RATE_HZ[rate] != sampleRate))
+    {
+        rate++;
+    }
+    if (rate == EQ_RATE_COUNT)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    // Start of the entry of this rate in the table of each kernel
+    pLowCoeffs = &LOW_BAND_RATE_COEFF[rate * (NUMBER_OF_BIQUAD_STAGES * LOW_BAND_RATE_BANDS * LOW_BAND_COEFF_PER_STAGE)];
+    pHighCoeffs = &EQ_RATE_BIQUAD_COEFF[rate * (NUMBER_OF_BIQUAD_STAGES * NUMBER_OF_BANDS * 5)];
+
+    B1.pCoeffs = &pLowCoeffs[0 * (NUMBER_OF_BIQUAD_STAGES * LOW_BAND_COEFF_PER_STAGE)];
+    B2.pCoeffs = &pLowCoeffs[1 * (NUMBER_OF_BIQUAD_STAGES * LOW_BAND_COEFF_PER_STAGE)];
+    B3.pCoeffs = &pLowCoeffs[2 * (NUMBER_OF_BIQUAD_STAGES * LOW_BAND_COEFF_PER_STAGE)];
+    B4.pCoeffs = &pHighCoeffs[3 * (NUMBER_OF_BIQUAD_STAGES * 5)];
+    B5.pCoeffs = &pHighCoeffs[4 * (NUMBER_OF_BIQUAD_STAGES * 5)];
+    B6.pCoeffs = &pHighCoeffs[5 * (NUMBER_OF_BIQUAD_STAGES * 5)];
+
+    memset(biquadStateBand1Q31, 0, sizeof(biquadStateBand1Q31));
+    memset(biquadStateBand2Q31, 0, sizeof(biquadStateBand2Q31));
+    memset(biquadStateBand3Q31, 0, sizeof(biquadStateBand3Q31));
+    memset(biquadStateBand4Q31, 0, sizeof(biquadStateBand4Q31));
+    memset(biquadStateBand5Q31, 0, sizeof(biquadStateBand5Q31));
+    memset(biquadStateBand6Q31, 0, sizeof(biquadStateBand6Q31));
+
+#if EQ_DYNAMICS
+    // The envelope times are in samples, so they follow the rate as well
+    ARM_Equalizer_dynamics_init(sampleRate);
+#endif
+#if EQ_RUNTIME_DESIGN
+    bankSampleRate = sampleRate;
+#endif
+
+    return ARM_MATH_SUCCESS;
+}
+#endif
+
+#if EQ_RUNTIME_DESIGN
+/**
+ *******************************************************************************
+ * @brief:     Redesigns all the bands on the device for octave bands centered
+ *             at baseFrequency * 2^band, with edges a half octave either side,
+ *             the same bank Eq_SciPy_ARM.py designs from BASE_FREQUENCY. Edges
+ *             above DESIGN_EDGE_LIMIT of the Nyquist frequency are limited. The
+ *             instances are pointed at the new coefficients and keep their
+ *             states, so a stream can be retuned without a restart. Call it
+ *             between two blocks, from the thread that runs ARM_Equalizer().
+ * @parameter: float64_t baseFrequency - Center of the first band [Hz]
+ * @return:    arm_status - ARM_MATH_ARGUMENT_ERROR if a band cannot be designed,
+ *                          in which case the bank keeps its coefficients
+ *******************************************************************************
+ */
+static arm_status ARM_Equalizer_retune(float64_t baseFrequency)
+{
+    q31_t coeffs[NUMBER_OF_BIQUAD_STAGES * NUMBER_OF_BANDS * 5];
+    const float64_t edgeLimit = DESIGN_EDGE_LIMIT * 0.5 * bankSampleRate;
+
+    // Design into a local table first so that a failed band changes nothing
+    for (uint32_t band = 0; band < NUMBER_OF_BANDS; band++)
+    {
+        const float64_t center = ldexp(baseFrequency, (int) band);
+        const float64_t lowcut = center * M_SQRT1_2;
+        const float64_t highcut = (center * M_SQRT2 < edgeLimit) ? center * M_SQRT2 : edgeLimit;
+
+        if (eq_butter_bandpass_q31(lowcut, highcut, bankSampleRate,
+                                   &coeffs[band * (NUMBER_OF_BIQUAD_STAGES * 5)]) != ARM_MATH_SUCCESS)
+        {
+            return ARM_MATH_ARGUMENT_ERROR;
+        }
+    }
+
+    memcpy(designedCoeff, coeffs, sizeof(designedCoeff));
+
+    B1.pCoeffs = &designedCoeff[0 * (NUMBER_OF_BIQUAD_STAGES * 5)];
+    B2.pCoeffs = &designedCoeff[1 * (NUMBER_OF_BIQUAD_STAGES * 5)];
+    B3.pCoeffs = &designedCoeff[2 * (NUMBER_OF_BIQUAD_STAGES * 5)];
+    B4.pCoeffs = &designedCoeff[3 * (NUMBER_OF_BIQUAD_STAGES * 5)];
+    B5.pCoeffs = &designedCoeff[4 * (NUMBER_OF_BIQUAD_STAGES * 5)];
+    B6.pCoeffs = &designedCoeff[5 * (NUMBER_OF_BIQUAD_STAGES * 5)];
+
+    return ARM_MATH_SUCCESS;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Designs a digital Butterworth bandpass of order
+ *             NUMBER_OF_BIQUAD_STAGES and quantizes its second-order sections
+ *             to the Q31 DF1 coefficients {b0, b1, b2, -a1, -a2} scaled by
+ *             2^-COEFFICIENT_POSTSHIFT, like Eq_SciPy_ARM.py does with SciPy:
+ *               1. Analog Butterworth lowpass prototype (buttap)
+ *               2. Lowpass to bandpass at the prewarped edges (lp2bp_zpk)
+ *               3. Bilinear transform (bilinear_zpk), the zeros end up at
+ *                  z = 1 and z = -1, NUMBER_OF_BIQUAD_STAGES of each
+ *               4. Sections as zpk2sos(pairing='nearest'): the pole closest
+ *                  to the unit circle goes into the last section, paired with
+ *                  the two nearest zeros, and the gain into the first section
+ *             The sections come straight from the poles rather than through
+ *             the polynomial and tf2zpk, so the zeros are exactly at z = +-1,
+ *             like butter_bandpass_sos() and Eq_ARM_bank.h. It uses no heap
+ *             and a fixed number of operations for a given order.
+ * @parameter: float64_t lowcut     - Lower -3 dB edge [Hz]
+ *             float64_t highcut    - Upper -3 dB edge [Hz]
+ *             float64_t sampleRate - Sampling rate [Hz]
+ *             q31_t* pCoeffs       - Points to the 5 * NUMBER_OF_BIQUAD_STAGES
+ *                                    coefficients to write
+ * @return:    arm_status - ARM_MATH_ARGUMENT_ERROR for edges outside of
+ *                          0..Nyquist or a band too wide for complex poles
+ *******************************************************************************
+ */
+static arm_status eq_butter_bandpass_q31(float64_t lowcut, float64_t highcut, float64_t sampleRate,
+                                         q31_t* pCoeffs)
+{
+    const uint32_t order = NUMBER_OF_BIQUAD_STAGES;
+    double complex poles[NUMBER_OF_BIQUAD_STAGES];
+    double complex sectionPole[NUMBER_OF_BIQUAD_STAGES];
+    float64_t sectionZeroSum[NUMBER_OF_BIQUAD_STAGES];
+    float64_t sectionZeroProduct[NUMBER_OF_BIQUAD_STAGES];
+    double complex poleProduct = 1.0;
+    uint32_t zerosPositive = order;
+    uint32_t zerosNegative = order;
+    uint32_t count = 0;
+    float64_t warpedLow;
+    float64_t warpedHigh;
+    float64_t bandwidth;
+    float64_t gain;
+
+    if ((lowcut <= 0.0) || (highcut <= lowcut) || (2.0 * highcut >= sampleRate))
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    // Prewarped edges of the analog design, SciPy designs at fs = 2
+    warpedLow = 4.0 * tan(M_PI * lowcut / sampleRate);
+    warpedHigh = 4.0 * tan(M_PI * highcut / sampleRate);
+    bandwidth = warpedHigh - warpedLow;
+
+    for (uint32_t pole = 0; pole < order; pole++)
+    {
+        // Pole of the analog lowpass prototype and its lowpass to bandpass pair
+        const double complex prototype = -cexp(I * M_PI * (float64_t) (2 * (int32_t) pole - (int32_t) order + 1) /
+                                               (2.0 * order));
+        const double complex lowpass = prototype * bandwidth / 2.0;
+        const double complex offset = csqrt(lowpass * lowpass - warpedLow * warpedHigh);
+
+        for (int32_t sign = -1; sign <= 1; sign += 2)
+        {
+            // Bilinear transform, keeping the pole in the upper half of each pair
+            const double complex analog = lowpass + sign * offset;
+            const double complex digital = (4.0 + analog) / (4.0 - analog);
+
+            poleProduct *= 4.0 - analog;
+            if (cimag(digital) > 0.0)
+            {
+                if (count == order)
+                {
+                    return ARM_MATH_ARGUMENT_ERROR;
+                }
+                poles[count++] = digital;
+            }
+        }
+    }
+
+    // Wider than ~2.5 octaves the real prototype pole gives a real pole pair
+    if (count != order)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    // Gain of the bandpass, bw^N, through the bilinear transform of its N zeros at s = 0
+    gain = pow(bandwidth, order) * creal(pow(4.0, order) / poleProduct);
+
+    // Pair the poles, the worst first into the last section, with the nearest zeros
+    for (int32_t section = order - 1; section >= 0; section--)
+    {
+        uint32_t worst = 0;
+
+        for (uint32_t pole = 1; pole < count; pole++)
+        {
+            if (fabs(1.0 - cabs(poles[pole])) < fabs(1.0 - cabs(poles[worst])))
+            {
+                worst = pole;
+            }
+        }
+        sectionPole[section] = poles[worst];
+        sectionZeroSum[section] = 0.0;
+        sectionZeroProduct[section] = 1.0;
+
+        for (uint32_t zero = 0; zero < 2; zero++)
+        {
+            const uint32_t positive = (zerosNegative == 0) ||
+                                      ((zerosPositive > 0) && (cabs(poles[worst] - 1.0) < cabs(poles[worst] + 1.0)));
+
+            sectionZeroSum[section] += positive ? 1.0 : -1.0;
+            sectionZeroProduct[section] *= positive ? 1.0 : -1.0;
+            zerosPositive -= positive;
+            zerosNegative -= !positive;
+        }
+
+        // Remove the pole, keeping the order of the others like numpy.delete
+        count--;
+        for (uint32_t pole = worst; pole < count; pole++)
+        {
+            poles[pole] = poles[pole + 1];
+        }
+    }
+
+    // Section coefficients in the CMSIS order, quantized like Eq_SciPy_ARM.py
+    for (uint32_t section = 0; section < order; section++)
+    {
+        const float64_t scale = ldexp((section == 0) ? gain : 1.0, 31 - COEFFICIENT_POSTSHIFT);
+        const float64_t coeffs[5] =
+        {
+            scale,
+            -scale * sectionZeroSum[section],
+            scale * sectionZeroProduct[section],
+            ldexp(2.0 * creal(sectionPole[section]), 31 - COEFFICIENT_POSTSHIFT),
+            ldexp(-creal(sectionPole[section] * conj(sectionPole[section])), 31 - COEFFICIENT_POSTSHIFT),
+        };
+
+        for (uint32_t coeff = 0; coeff < 5; coeff++)
+        {
+            pCoeffs[section * 5 + coeff] = (q31_t) nearbyint(coeffs[coeff]);
+        }
+    }
+
+    return ARM_MATH_SUCCESS;
+}
+#endif
+
+/**
+ *******************************************************************************
+ * @brief:     Modified Bessel function of the first kind and order 0, by its
+ *             power series I0(x) = sum_k ((x / 2)^k / k!)^2, for the Kaiser window
+ * @parameter: float64_t x - Argument, 0..SRC_KAISER_BETA
+ * @return:    float64_t - I0(x)
+ *******************************************************************************
+ */
+static float64_t eq_bessel_i0(float64_t x)
+{
+    float64_t sum = 1.0;
+    float64_t term = 1.0;
+
+    // 30 terms converge to double precision for x up to ~15
+    for (uint32_t k = 1; k < 30; k++)
+    {
+        term *= 0.5 * x / k;
+        sum += term * term;
+    }
+
+    return sum;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Designs the Q31 prototype lowpass of the SRC, a windowed sinc with
+ *             a Kaiser window (SRC_KAISER_BETA) scaled to an exact DC gain. The
+ *             taps beyond numTaps are zero so that the polyphase branches all
+ *             have the same length. The filter is symmetric, so it also is in
+ *             the time reversed order the CMSIS FIR functions expect.
+ * @parameter: q31_t* pCoeffs   - Points to the coefficient buffer
+ *             uint32_t numTaps - Length of the windowed sinc
+ *             uint32_t length  - Length of the buffer, numTaps or more
+ *             float64_t cutoff - Cutoff frequency relative to the sampling rate
+ *             float64_t gain   - DC gain of the filter
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_src_design_q31(q31_t* pCoeffs, uint32_t numTaps, uint32_t length,
+                              float64_t cutoff, float64_t gain)
+{
+    const float64_t center = 0.5 * (numTaps - 1);
+    const float64_t windowNorm = eq_bessel_i0(SRC_KAISER_BETA);
+    float64_t sum = 0.0;
+    float64_t scale = 0.0;
+
+    // The taps are computed twice, first for their sum and then to quantize them,
+    // rather than keeping a double copy of the whole prototype
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        for (uint32_t tap = 0; tap < numTaps; tap++)
+        {
+            const float64_t t = tap - center;
+            const float64_t r = t / center;
+            const float64_t window = eq_bessel_i0(SRC_KAISER_BETA * sqrt(1.0 - r * r)) / windowNorm;
+            const float64_t sinc = (t == 0.0) ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+
+            if (pass == 0)
+            {
+                sum += sinc * window;
+            }
+            else
+            {
+                pCoeffs[tap] = (q31_t) round(sinc * window * scale * 2147483648.0);
+            }
+        }
+
+        scale = gain / sum;
+    }
+
+    memset(&pCoeffs[numTaps], 0, (length - numTaps) * sizeof(q31_t));
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Inits the Q31 polyphase rational resampler
+ * @parameter: eq_fir_resample_ins_q31* S - Points to the instance
+ *             uint16_t L                 - Interpolation factor
+ *             uint16_t M                 - Decimation factor
+ *             uint16_t phaseLength       - Taps of every polyphase branch
+ *             const q31_t* pCoeffs       - Points to the prototype filter of
+ *                                          phaseLength * L taps
+ *             q31_t* pState              - Points to the state buffer of size
+ *                                          phaseLength + blockSize - 1
+ *             uint32_t blockSize         - Largest number of input samples
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_fir_resample_init_q31(eq_fir_resample_ins_q31* S, uint16_t L, uint16_t M,
+                                     uint16_t phaseLength, const q31_t* pCoeffs,
+                                     q31_t* pState, uint32_t blockSize)
+{
+    S->L = L;
+    S->M = M;
+    S->phaseLength = phaseLength;
+    S->position = 0;
+    S->pCoeffs = pCoeffs;
+    S->pState = pState;
+
+    // Clear the past input samples
+    memset(pState, 0, (phaseLength + blockSize - 1U) * sizeof(q31_t));
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Q31 polyphase rational resampler, interpolates by L and decimates
+ *             by M. Output j lies at j * M on the grid of L times the input
+ *             rate, which is input sample q = (j * M) / L with the polyphase
+ *             branch p = (j * M) % L, so
+ *                 y[j] = sum_m h[p + m * L] * x[q - m],  m = 0..phaseLength-1
+ *             Only the taps that meet an input sample are computed. As in the
+ *             CMSIS FIR functions the products are accumulated in 64 bits and
+ *             truncated to Q31, and a block of blockSize input samples gives
+ *             blockSize * L / M outputs once it is a multiple of M.
+ * @parameter: eq_fir_resample_ins_q31* S - Points to the instance
+ *             const q31_t* pSrc          - Pointer to the source buffer
+ *             q31_t* pDst                - Pointer to the destination buffer
+ *             uint32_t blockSize         - Number of input samples
+ * @return:    uint32_t - Number of output samples written
+ *******************************************************************************
+ */
+static uint32_t eq_fir_resample_q31(eq_fir_resample_ins_q31* S, const q31_t* pSrc,
+                                    q31_t* pDst, uint32_t blockSize)
+{
+    const uint32_t L = S->L;
+    const uint32_t phaseLength = S->phaseLength;
+    const uint32_t end = blockSize * L;
+    q31_t* const pState = S->pState;
+    uint32_t position = S->position;
+    uint32_t outputs = 0;
+
+    // The new samples go behind the (phaseLength - 1) samples of the last block
+    memcpy(&pState[phaseLength - 1U], pSrc, blockSize * sizeof(q31_t));
+
+    while (position < end)
+    {
+        // Newest input sample of this output and the first tap of its branch
+        const q31_t* pX = &pState[phaseLength - 1U + position / L];
+        const q31_t* pH = &S->pCoeffs[position % L];
+        q63_t acc = 0;
+
+        for (uint32_t tap = 0; tap < phaseLength; tap++)
+        {
+            acc += (q63_t) *pH * *pX--;
+            pH += L;
+        }
+
+        pDst[outputs++] = (q31_t) (acc >> 31);
+        position += S->M;
+    }
+
+    // Keep the position relative to the next block and its past samples
+    S->position = position - end;
+    memmove(pState, &pState[blockSize], (phaseLength - 1U) * sizeof(q31_t));
+
+    return outputs;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     User custom data obtaining implemenation. This can be changed 
+ * @parameter: int16_t* databuf - Pointer to the data buffer
+ * @return:    N/A
+ *******************************************************************************
+ */
+__attribute__((weak)) void user_custom_data_obtaining(int16_t* databuf)
+{
+    // Default weak implementation
+	UNUSED(databuf);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     User custom data transfer implemenation. This can be changed 
+ * @parameter: int16_t* databuf - Pointer to the data buffer
+ * @return:    N/A
+ *******************************************************************************
+ */
+__attribute__((weak)) void user_custom_data_transfer(int16_t* databuf)
+{
+    // Default weak implementation
+	UNUSED(databuf);
+}
+
+#if EQ_LATENCY
+/**
+ *******************************************************************************
+ * @brief:     User custom data obtaining with the capture time of the block for
+ *             the latency histograms. This can be changed to report when the
+ *             DMA/ISR completed the block: CLOCK_MONOTONIC nanoseconds on the
+ *             host, the DWT CYCCNT on the Cortex-M.
+ * @parameter: int16_t* databuf - Pointer to the data buffer
+ *             uint64_t* pCaptured - Capture time of the block [ticks]
+ * @return:    N/A
+ *******************************************************************************
+ */
+__attribute__((weak)) void user_custom_data_obtaining_timed(int16_t* databuf, uint64_t* pCaptured)
+{
+    // Default weak implementation, the block counts as captured once it is handed over
+    user_custom_data_obtaining(databuf);
+    *pCaptured = eq_latency_now();
 }
+#endif
 
 // ************************************End of file******************************
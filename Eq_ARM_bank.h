@@ -0,0 +1,73 @@
+/**
+ *******************************************************************************
+ * @file:    Eq_ARM_bank.h
+ * @brief:   Q31 coefficients of the equalizer bank of Eq_ARM.c at SAMPLE_RATE_HZ.
+ *           Generated by Eq_SciPy_ARM.py (HEADLESS or --headless), do not edit.
+ *******************************************************************************
+ */
+
+#ifndef EQ_ARM_BANK_H
+#define EQ_ARM_BANK_H
+
+// Layout of the tables, checked against the defines of Eq_ARM.c
+#define EQ_BANK_SAMPLE_RATE_HZ  16000
+#define EQ_BANK_STAGES          3
+#define EQ_BANK_BANDS           6
+#define EQ_BANK_COUPLED_BANDS   3
+#define EQ_BANK_POSTSHIFT       4
+
+// 3 stages * 6 bands * 5 coefficients for each biquad
+const q31_t BIQUAD_COEFF[EQ_BANK_STAGES * EQ_BANK_BANDS * 5] =
+{
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    349, 699, 349, 264555166, -130541571,
+    134217728, 0, -134217728, 265663083, -131823455,
+    134217728, -268435456, 134217728, 267019283, -132913273,
+
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    2721, 5441, 2721, 260375768, -126963382,
+    134217728, 0, -134217728, 262193941, -129474301,
+    134217728, -268435456, 134217728, 265393561, -131620458,
+
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    20635, 41271, 20635, 251164150, -120080476,
+    134217728, 0, -134217728, 253261157, -124917151,
+    134217728, -268435456, 134217728, 261522959, -129065288,
+
+    // Bandpass #4: 565.7 Hz to 1131.4 Hz
+    149046, 298093, 149046, 229631975, -107282897,
+    134217728, 0, -134217728, 228128773, -116401482,
+    134217728, -268435456, 134217728, 251380082, -124047183,
+
+    // Bandpass #5: 1131.4 Hz to 2262.7 Hz
+    988093, 1976186, 988093, 176457518, -84757405,
+    134217728, 0, -134217728, 154862258, -101974490,
+    134217728, -268435456, 134217728, 222216381, -114157820,
+
+    // Bandpass #6: 2262.7 Hz to 4525.5 Hz
+    5760975, 0, -5760975, 47472643, -47645430,
+    134217728, 268435456, 134217728, -34439088, -85267947,
+    134217728, -268435456, 134217728, 136338823, -93133606,
+};
+
+// 3 stages * 3 low bands * 6 coefficients for each coupled-form section, only
+// used when LOW_BAND_KERNEL is LOW_BAND_KERNEL_COUPLED
+const q31_t BIQUAD_COEFF_COUPLED[EQ_BANK_STAGES * EQ_BANK_COUPLED_BANDS * 6] =
+{
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    349, 2097152, 132277583, 4861491, 88811, 2433400,
+    134217728, 134217728, 132831541, 6987581, 265663083, -59964447,
+    134217728, 2097152, 133509641, 3806995, -90635099, -235218790,
+
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    2721, 4194304, 130187884, 9583915, 343003, 4725251,
+    134217728, 268435456, 131096971, 13832241, 131096971, -36845575,
+    134217728, 4194304, 132696780, 7573862, -97340650, -232589825,
+
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    20635, 8388608, 125582075, 18602987, 1278177, 8879422,
+    134217728, 268435456, 126630578, 27033179, 126630578, -50121517,
+    134217728, 8388608, 130761480, 14976151, -110599947, -226856092,
+};
+
+#endif // EQ_ARM_BANK_H
@@ -0,0 +1,825 @@
+/**
+ *******************************************************************************
+ * @file:    Eq_ARM_bench.c
+ * @brief:   Host micro-benchmark of the equalizer engine of Eq_ARM.c. Every
+ *           stage ARM_Equalizer() runs and the whole function are timed over
+ *           block sizes from 1 to BENCH_MAX_BLOCK samples, on input_file.wav
+ *           and on synthetic signals. The results are written as JSON in
+ *           cycles and nanoseconds per sample and samples per second, so that
+ *           two builds can be compared stage by stage.
+ *
+ * @Note:    Eq_ARM.c is compiled in here as it is, without its main(), and
+ *           against the same CMSIS-DSP sources as setup.py plus the three
+ *           reference functions of the unfused path:
+ *
+ *               S=$CMSIS_DSP/Source
+ *               cc -std=gnu11 -O3 -I. -I$CMSIS_DSP/Include -I$CMSIS_DSP/PrivateInclude \
+ *                  Eq_ARM_bench.c <the CMSIS_SOURCES of setup.py in $S> \
+ *                  $S/SupportFunctions/arm_q15_to_q31.c $S/BasicMathFunctions/arm_scale_q31.c \
+ *                  $S/BasicMathFunctions/arm_add_q31.c -lm -o Eq_ARM_bench
+ *               ./Eq_ARM_bench [--perf] [input_file.wav [results.json]]
+ *
+ *           The configuration of Eq_ARM.c is set with -D as usual, e.g.
+ *           -DSTREAM_SAMPLE_RATE_HZ=48000. All figures are per sample of the
+ *           stream, also for the stages that run at the bank rate behind the
+ *           SRC. Cycles are TSC reference cycles on x86 and left out elsewhere.
+ *
+ *           With --perf the hardware counters of Linux (perf_event_open) run
+ *           around every measurement as well: core cycles, instructions, L1D
+ *           read misses and branch misses, reported as IPC and per sample. This
+ *           tells a kernel bound by its multiplies (high IPC, few misses) from
+ *           one waiting on memory. It needs kernel.perf_event_paranoid <= 2
+ *           and a machine that exposes the counters, which VMs often do not.
+ *
+ *           ARM_Equalizer() no longer calls arm_q15_to_q31(), arm_scale_q31()
+ *           and arm_add_q31(): the conversion and the exponent are one pass
+ *           (ARM_Equalizer_convert) and so are the band gains and the sum
+ *           (ARM_Equalizer_mix). The CMSIS functions are timed as well, as the
+ *           reference these passes replace.
+ *
+ *******************************************************************************
+ */
+
+//******************************************************************************
+//  Include Files
+//******************************************************************************
+
+// STANDARD DEFINITONS
+#include <stdlib.h>
+#include <time.h>
+
+// CYCLE COUNTER
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// HARDWARE COUNTERS, for --perf
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// THE EQUALIZER ENGINE, without its main() and with room for the largest block
+#ifndef SAMPLES_PER_TRANSFER
+#define SAMPLES_PER_TRANSFER    8192
+#endif
+#define EQ_NO_MAIN 1
+#include "Eq_ARM.c"
+
+//******************************************************************************
+//  Defines
+//******************************************************************************
+
+#define BENCH_MAX_BLOCK         8192  // Largest block size, the sizes double from 1
+#define BENCH_SIGNAL_SAMPLES    65536 // Length of the synthetic signals
+#define BENCH_WAV_SAMPLES_MAX   (1U << 22) // Longest part of a WAV file that is used
+#define BENCH_REPEATS           5     // Runs per measurement, the fastest is reported
+#define BENCH_LEVEL             16384 // Amplitude of the synthetic signals, -6 dBFS
+#define BENCH_SINE_HZ           1000.0
+
+#if (BENCH_MAX_BLOCK > SAMPLES_PER_TRANSFER)
+#error "SAMPLES_PER_TRANSFER has to hold BENCH_MAX_BLOCK samples"
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_CYCLE_COUNTER     "rdtsc"
+#else
+#define BENCH_CYCLE_COUNTER     NULL  // No cycle counter, only the time is reported
+#endif
+
+// Hardware counters of --perf, the cycles lead the group
+#define BENCH_PERF_CYCLES        0
+#define BENCH_PERF_INSTRUCTIONS  1
+#define BENCH_PERF_L1D_MISSES    2
+#define BENCH_PERF_BRANCH_MISSES 3
+#define BENCH_PERF_COUNTERS      4
+
+// Name of the selected low band kernel
+#if (LOW_BAND_KERNEL == LOW_BAND_KERNEL_DF1_32X64)
+#define BENCH_LOW_BAND_NAME     "biquad_df1_32x64"
+#elif (LOW_BAND_KERNEL == LOW_BAND_KERNEL_DF1_EF)
+#define BENCH_LOW_BAND_NAME     "biquad_df1_ef"
+#else
+#define BENCH_LOW_BAND_NAME     "biquad_coupled"
+#endif
+
+//******************************************************************************
+//  Types
+//******************************************************************************
+
+// One operation under test. pSrc and pSrcQ31 point at the block in the int16
+// and Q31 copies of the signal, blocksize counts stream samples and
+// bankBlocksize the samples at the bank rate.
+typedef struct
+{
+    const char* name;
+    const char* stage; // Stage of ARM_Equalizer(), NULL for the reference functions
+    void (*run)(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+} bench_op_t;
+
+// One input signal
+typedef struct
+{
+    const char* name;
+    int16_t*    pSamples;
+    q31_t*      pSamplesQ31; // The same at the scale of the bank input
+    uint32_t    length;
+} bench_signal_t;
+
+// One hardware counter of --perf
+typedef struct
+{
+    const char* name;   // Name in the results, per sample
+    uint32_t    type;   // perf_event_attr type
+    uint64_t    config; // perf_event_attr config
+} bench_counter_t;
+
+//******************************************************************************
+//  Static Variables
+//******************************************************************************
+
+// perf_event descriptors of the counters, -1 if not open
+static int benchCounterFds[BENCH_PERF_COUNTERS] = { -1, -1, -1, -1 };
+static int benchPerf = 0; // Set by --perf
+
+// Outputs of the operations that do not write to the buffers of Eq_ARM.c
+static q31_t   benchQ31[STREAM_SAMPLES_PER_TRANSFER];
+static int16_t benchOutput[STREAM_SAMPLES_PER_TRANSFER];
+
+//******************************************************************************
+//  Function Prototypes
+//******************************************************************************
+
+// Operations under test
+static void bench_exponent(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_convert(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_low_band(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_high_band(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_mix(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_output(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_end_to_end(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_q15_to_q31(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_scale_q31(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_add_q31(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+#if SRC_ENABLED
+static void bench_src_down(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+static void bench_src_up(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize);
+#endif
+
+// Harness
+static uint64_t bench_cycles(void);
+static uint64_t bench_nanoseconds(void);
+static int16_t* bench_read_wav(const char* pPath, uint32_t* pLength);
+static void bench_signal_init(bench_signal_t* pSignal, const char* pName, int16_t* pSamples, uint32_t length);
+static void bench_measure(FILE* pFile, const bench_op_t* pOp, const bench_signal_t* pSignal, uint16_t blocksize,
+                          int first);
+
+// Hardware counters
+static int bench_perf_open(void);
+static void bench_perf_start(void);
+static void bench_perf_stop(float64_t* pCounts);
+
+//******************************************************************************
+//  Static Constants
+//******************************************************************************
+
+// Stages of ARM_Equalizer() in the order it runs them, then the whole function
+// and the CMSIS reference of the fused passes. The band kernels are timed on a
+// single band, ARM_Equalizer() runs each of them on three.
+static const bench_op_t benchOps[] =
+{
+    { "exponent",          "exponent",  bench_exponent },
+    { "convert",           "convert",   bench_convert },
+#if SRC_ENABLED
+    { "src_down",          "src_down",  bench_src_down },
+#endif
+    { BENCH_LOW_BAND_NAME, "low_band",  bench_low_band },
+    { "biquad_df1_32x32",  "high_band", bench_high_band },
+    { "mix",               "mix",       bench_mix },
+#if SRC_ENABLED
+    { "src_up",            "src_up",    bench_src_up },
+#endif
+    { "arm_q31_to_q15",    "output",    bench_output },
+    { "end_to_end",        "all",       bench_end_to_end },
+    { "arm_q15_to_q31",    NULL,        bench_q15_to_q31 },
+    { "arm_scale_q31",     NULL,        bench_scale_q31 },
+    { "arm_add_q31",       NULL,        bench_add_q31 },
+};
+
+#if defined(__linux__)
+// Counters of --perf in the order of the BENCH_PERF_ indices
+static const bench_counter_t benchCounters[BENCH_PERF_COUNTERS] =
+{
+    { "core_cycles",   PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "l1d_misses",    PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+#endif
+
+//******************************************************************************
+//  Functions
+//******************************************************************************
+
+/**
+ *******************************************************************************
+ * @brief:     Runs every operation on every signal and block size and writes
+ *             the results as JSON
+ * @parameter: int argc    - Number of arguments
+ *             char** argv - Optional --perf, WAV file (input_file.wav by
+ *                           default) and JSON file (stdout by default)
+ * @return:    int - 0 on success
+ *******************************************************************************
+ */
+int main(int argc, char** argv)
+{
+    const char* pPaths[2] = { "input_file.wav", NULL };
+    const char* pWavPath;
+    uint32_t numPaths = 0;
+    FILE* pFile = stdout;
+    bench_signal_t signals[4];
+    uint32_t numSignals = 0;
+    uint32_t wavLength = 0;
+    int16_t* pWav;
+    int16_t* pNoise = malloc(BENCH_SIGNAL_SAMPLES * sizeof(int16_t));
+    int16_t* pSine = malloc(BENCH_SIGNAL_SAMPLES * sizeof(int16_t));
+    int16_t* pSilence = calloc(BENCH_SIGNAL_SAMPLES, sizeof(int16_t));
+    uint32_t seed = 1;
+    uint32_t previous = 0;
+    int first = 1;
+
+    if ((pNoise == NULL) || (pSine == NULL) || (pSilence == NULL))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--perf") == 0)
+        {
+            benchPerf = 1;
+        }
+        else if (numPaths < 2)
+        {
+            pPaths[numPaths++] = argv[arg];
+        }
+    }
+    pWavPath = pPaths[0];
+
+    if (benchPerf && (bench_perf_open() != 0))
+    {
+        return 1;
+    }
+
+    // The recording, if there is one, and white noise, a sine and silence. Silence
+    // runs the block floating point at its largest exponent.
+    pWav = bench_read_wav(pWavPath, &wavLength);
+    if (pWav != NULL)
+    {
+        bench_signal_init(&signals[numSignals++], pWavPath, pWav, wavLength);
+    }
+    for (uint32_t sample = 0; sample < BENCH_SIGNAL_SAMPLES; sample++)
+    {
+        seed = seed * 1664525U + 1013904223U;
+        pNoise[sample] = (int16_t) ((int32_t) (seed >> 16) * 2 * BENCH_LEVEL / 65536 - BENCH_LEVEL);
+        pSine[sample] = (int16_t) (BENCH_LEVEL * sin(2.0 * M_PI * BENCH_SINE_HZ * sample / STREAM_SAMPLE_RATE_HZ));
+    }
+    bench_signal_init(&signals[numSignals++], "noise", pNoise, BENCH_SIGNAL_SAMPLES);
+    bench_signal_init(&signals[numSignals++], "sine", pSine, BENCH_SIGNAL_SAMPLES);
+    bench_signal_init(&signals[numSignals++], "silence", pSilence, BENCH_SIGNAL_SAMPLES);
+
+    if ((pPaths[1] != NULL) && ((pFile = fopen(pPaths[1], "w")) == NULL))
+    {
+        fprintf(stderr, "Cannot write %s\n", pPaths[1]);
+        return 1;
+    }
+
+    fprintf(pFile, "{\n  \"config\": {\"sample_rate_hz\": %d, \"stream_sample_rate_hz\": %d, \"bands\": %d, "
+            "\"stages\": %d, \"postshift\": %d, \"low_band_kernel\": \"%s\", \"repeats\": %d, \"cycle_counter\": ",
+            SAMPLE_RATE_HZ, STREAM_SAMPLE_RATE_HZ, NUMBER_OF_BANDS, NUMBER_OF_BIQUAD_STAGES,
+            COEFFICIENT_POSTSHIFT, BENCH_LOW_BAND_NAME, BENCH_REPEATS);
+    fprintf(pFile, (BENCH_CYCLE_COUNTER != NULL) ? "\"%s\", " : "null, ",
+            (BENCH_CYCLE_COUNTER != NULL) ? BENCH_CYCLE_COUNTER : "");
+    fprintf(pFile, "\"perf\": %s},\n", benchPerf ? "true" : "false");
+    fprintf(pFile, "  \"results\": [");
+
+    // Block sizes double from 1 up to BENCH_MAX_BLOCK, rounded down to whole periods
+    // of the SRC but at least one
+    for (uint32_t size = 1; size <= BENCH_MAX_BLOCK; size *= 2)
+    {
+        const uint32_t blocksize = (size < SRC_DECIMATION) ? SRC_DECIMATION : (size / SRC_DECIMATION) * SRC_DECIMATION;
+
+        if (blocksize == previous)
+        {
+            continue;
+        }
+        previous = blocksize;
+
+        for (uint32_t signal = 0; signal < numSignals; signal++)
+        {
+            for (uint32_t op = 0; op < sizeof(benchOps) / sizeof(benchOps[0]); op++)
+            {
+                bench_measure(pFile, &benchOps[op], &signals[signal], (uint16_t) blocksize, first);
+                first = 0;
+            }
+        }
+    }
+
+    fprintf(pFile, "\n  ]\n}\n");
+    if (pFile != stdout)
+    {
+        fclose(pFile);
+    }
+
+    return 0;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Times one operation on one signal and block size and writes the
+ *             result. The engine is reset and primed with one block before
+ *             every run, and the fastest of BENCH_REPEATS runs is reported,
+ *             with its hardware counts if --perf is on.
+ * @parameter: FILE* pFile                  - JSON output
+ *             const bench_op_t* pOp        - Operation under test
+ *             const bench_signal_t* pSignal - Input signal
+ *             uint16_t blocksize           - Block size at the stream rate
+ *             int first                    - 0 if a result was written before
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void bench_measure(FILE* pFile, const bench_op_t* pOp, const bench_signal_t* pSignal, uint16_t blocksize,
+                          int first)
+{
+    const uint16_t bankBlocksize = (blocksize / SRC_DECIMATION) * SRC_INTERPOLATION;
+    const uint32_t blocks = pSignal->length / blocksize;
+    const uint32_t samples = blocks * blocksize;
+    uint64_t bestCycles = UINT64_MAX;
+    uint64_t bestNanoseconds = UINT64_MAX;
+    float64_t bestCounts[BENCH_PERF_COUNTERS] = { 0 };
+
+    if (blocks == 0)
+    {
+        return;
+    }
+
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++)
+    {
+        uint64_t cycles;
+        uint64_t nanoseconds;
+
+        // Same state for every run, with the band outputs of a real block for the mix
+        ARM_Equalizer_init();
+        ARM_Equalizer(pSignal->pSamples, benchOutput, blocksize);
+
+        if (benchPerf)
+        {
+            bench_perf_start();
+        }
+        nanoseconds = bench_nanoseconds();
+        cycles = bench_cycles();
+        for (uint32_t block = 0; block < blocks; block++)
+        {
+            pOp->run(&pSignal->pSamples[block * blocksize], &pSignal->pSamplesQ31[block * blocksize],
+                     blocksize, bankBlocksize);
+        }
+        cycles = bench_cycles() - cycles;
+        nanoseconds = bench_nanoseconds() - nanoseconds;
+
+        if (benchPerf)
+        {
+            float64_t counts[BENCH_PERF_COUNTERS];
+
+            bench_perf_stop(counts);
+            if (nanoseconds < bestNanoseconds)
+            {
+                memcpy(bestCounts, counts, sizeof(bestCounts));
+            }
+        }
+        bestCycles = (cycles < bestCycles) ? cycles : bestCycles;
+        bestNanoseconds = (nanoseconds < bestNanoseconds) ? nanoseconds : bestNanoseconds;
+    }
+
+    fprintf(pFile, "%s\n    {\"signal\": \"%s\", \"block_size\": %u, \"operation\": \"%s\", \"stage\": ",
+            first ? "" : ",", pSignal->name, blocksize, pOp->name);
+    fprintf(pFile, (pOp->stage != NULL) ? "\"%s\", " : "null, ", (pOp->stage != NULL) ? pOp->stage : "");
+    fprintf(pFile, "\"samples\": %u, \"cycles_per_sample\": ", samples);
+    fprintf(pFile, (BENCH_CYCLE_COUNTER != NULL) ? "%.3f" : "null", (float64_t) bestCycles / samples);
+    fprintf(pFile, ", \"ns_per_sample\": %.3f, \"samples_per_second\": %.0f",
+            (float64_t) bestNanoseconds / samples, (bestNanoseconds > 0) ? 1e9 * samples / bestNanoseconds : 0.0);
+
+#if defined(__linux__)
+    // Counts per sample of the fastest run, null for the counters the machine lacks
+    if (benchPerf)
+    {
+        fprintf(pFile, ", \"ipc\": ");
+        fprintf(pFile, ((benchCounterFds[BENCH_PERF_INSTRUCTIONS] >= 0) && (bestCounts[BENCH_PERF_CYCLES] > 0)) ?
+                "%.3f" : "null", bestCounts[BENCH_PERF_INSTRUCTIONS] / bestCounts[BENCH_PERF_CYCLES]);
+        for (uint32_t counter = 0; counter < BENCH_PERF_COUNTERS; counter++)
+        {
+            fprintf(pFile, ", \"%s_per_sample\": ", benchCounters[counter].name);
+            fprintf(pFile, (benchCounterFds[counter] >= 0) ? "%.4f" : "null", bestCounts[counter] / samples);
+        }
+    }
+#endif
+    fprintf(pFile, "}");
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Block floating point exponent, including the rescale of the
+ *             filter states when it changes
+ *******************************************************************************
+ */
+static void bench_exponent(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrcQ31);
+    UNUSED(bankBlocksize);
+    ARM_Equalizer_exponent(pSrc, blocksize);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Conversion of the input to Q31 with the exponent applied
+ *******************************************************************************
+ */
+static void bench_convert(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrcQ31);
+    UNUSED(bankBlocksize);
+    ARM_Equalizer_convert(pSrc, blockExponent, blocksize);
+}
+
+#if SRC_ENABLED
+/**
+ *******************************************************************************
+ * @brief:     Resampling of the stream down to the bank rate
+ *******************************************************************************
+ */
+static void bench_src_down(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrc);
+    UNUSED(bankBlocksize);
+#if (SRC_INTERPOLATION == 1)
+    arm_fir_decimate_q31(&srcDown, pSrcQ31, q31Src, blocksize);
+#else
+    eq_fir_resample_q31(&srcDown, pSrcQ31, q31Src, blocksize);
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Resampling of the mix back up to the stream rate
+ *******************************************************************************
+ */
+static void bench_src_up(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrc);
+    UNUSED(pSrcQ31);
+    UNUSED(blocksize);
+#if (SRC_INTERPOLATION == 1)
+    arm_fir_interpolate_q31(&srcUp, q31Dest, q31Stream, bankBlocksize);
+#else
+    eq_fir_resample_q31(&srcUp, q31Dest, q31Stream, bankBlocksize);
+#endif
+}
+#endif
+
+/**
+ *******************************************************************************
+ * @brief:     One band of the low band kernel (LOW_BAND_FILTER)
+ *******************************************************************************
+ */
+static void bench_low_band(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrc);
+    UNUSED(blocksize);
+    LOW_BAND_FILTER(&B1, pSrcQ31, outputB1, bankBlocksize);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     One band of the 32x32 DF1 kernel of the high bands
+ *******************************************************************************
+ */
+static void bench_high_band(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrc);
+    UNUSED(blocksize);
+    arm_biquad_cascade_df1_q31(&B4, pSrcQ31, outputB4, bankBlocksize);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Band gains and sum of all bands
+ *******************************************************************************
+ */
+static void bench_mix(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrc);
+    UNUSED(pSrcQ31);
+    UNUSED(blocksize);
+    ARM_Equalizer_mix(blockExponent, bankBlocksize);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Conversion of the output to int16
+ *******************************************************************************
+ */
+static void bench_output(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrc);
+    UNUSED(bankBlocksize);
+    arm_q31_to_q15(pSrcQ31, benchOutput, blocksize);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     The whole equalizer
+ *******************************************************************************
+ */
+static void bench_end_to_end(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrcQ31);
+    UNUSED(bankBlocksize);
+    ARM_Equalizer(pSrc, benchOutput, blocksize);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     CMSIS conversion to Q31, the reference of the convert stage
+ *******************************************************************************
+ */
+static void bench_q15_to_q31(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrcQ31);
+    UNUSED(bankBlocksize);
+    arm_q15_to_q31(pSrc, benchQ31, blocksize);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     CMSIS scaling, once per block it stands for the input scaling and
+ *             once per band for the band gains of the mix
+ *******************************************************************************
+ */
+static void bench_scale_q31(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrc);
+    UNUSED(bankBlocksize);
+    arm_scale_q31(pSrcQ31, 0x7FFFFFFF, -HEADROOM_BITS, benchQ31, blocksize);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     CMSIS saturating add, the reference of the sum of two bands
+ *******************************************************************************
+ */
+static void bench_add_q31(int16_t* pSrc, const q31_t* pSrcQ31, uint16_t blocksize, uint16_t bankBlocksize)
+{
+    UNUSED(pSrc);
+    UNUSED(bankBlocksize);
+    arm_add_q31(pSrcQ31, benchQ31, benchQ31, blocksize);
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Reads the cycle counter of the host
+ * @parameter: N/A
+ * @return:    uint64_t - Cycle count, 0 without a counter
+ *******************************************************************************
+ */
+static uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Opens the hardware counters of --perf as one group, so that they
+ *             always count together. Only the user space of this thread counts.
+ *             A counter the machine does not have is left out, but without the
+ *             cycles, which lead the group, there is nothing to measure.
+ * @parameter: N/A
+ * @return:    int - 0 on success
+ *******************************************************************************
+ */
+static int bench_perf_open(void)
+{
+#if defined(__linux__)
+    for (uint32_t counter = 0; counter < BENCH_PERF_COUNTERS; counter++)
+    {
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.type = benchCounters[counter].type;
+        attr.size = sizeof(attr);
+        attr.config = benchCounters[counter].config;
+        attr.disabled = (counter == BENCH_PERF_CYCLES);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        benchCounterFds[counter] = (int) syscall(SYS_perf_event_open, &attr, 0, -1,
+                                                 benchCounterFds[BENCH_PERF_CYCLES], 0);
+        if (benchCounterFds[counter] < 0)
+        {
+            fprintf(stderr, "No %s counter: %s\n", benchCounters[counter].name, strerror(errno));
+            if (counter == BENCH_PERF_CYCLES)
+            {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+#else
+    fprintf(stderr, "--perf needs the perf_event counters of Linux\n");
+    return 1;
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Clears and starts the hardware counters
+ * @parameter: N/A
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void bench_perf_start(void)
+{
+#if defined(__linux__)
+    ioctl(benchCounterFds[BENCH_PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(benchCounterFds[BENCH_PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Stops the hardware counters and reads them. A count is scaled up
+ *             by the share of the time it ran, in case the kernel had to
+ *             multiplex the group with other users of the counters.
+ * @parameter: float64_t* pCounts - BENCH_PERF_COUNTERS counts to fill
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void bench_perf_stop(float64_t* pCounts)
+{
+#if defined(__linux__)
+    ioctl(benchCounterFds[BENCH_PERF_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    for (uint32_t counter = 0; counter < BENCH_PERF_COUNTERS; counter++)
+    {
+        uint64_t value[3]; // Count, time enabled, time running
+
+        pCounts[counter] = 0.0;
+        if ((benchCounterFds[counter] >= 0) &&
+            (read(benchCounterFds[counter], value, sizeof(value)) == sizeof(value)) && (value[2] > 0))
+        {
+            pCounts[counter] = (float64_t) value[0] * value[1] / value[2];
+        }
+    }
+#else
+    UNUSED(pCounts);
+#endif
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Reads the monotonic clock
+ * @parameter: N/A
+ * @return:    uint64_t - Time [ns]
+ *******************************************************************************
+ */
+static uint64_t bench_nanoseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000U + (uint64_t) now.tv_nsec;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Sets up a signal and its copy at the scale of the bank input, the
+ *             input of the stages that take Q31 samples
+ * @parameter: bench_signal_t* pSignal - Signal to set up
+ *             const char* pName       - Name in the results
+ *             int16_t* pSamples       - Samples, owned by the signal from now on
+ *             uint32_t length         - Number of samples
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void bench_signal_init(bench_signal_t* pSignal, const char* pName, int16_t* pSamples, uint32_t length)
+{
+    pSignal->name = pName;
+    pSignal->pSamples = pSamples;
+    pSignal->length = length;
+    pSignal->pSamplesQ31 = malloc(length * sizeof(q31_t));
+    if (pSignal->pSamplesQ31 == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    for (uint32_t sample = 0; sample < length; sample++)
+    {
+        pSignal->pSamplesQ31[sample] = (q31_t) pSamples[sample] << (16 - HEADROOM_BITS);
+    }
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Reads the first channel of a 16-bit PCM WAV file
+ * @parameter: const char* pPath - Path of the file
+ *             uint32_t* pLength - Number of samples read
+ * @return:    int16_t* - Samples, NULL if the file cannot be used
+ *******************************************************************************
+ */
+static int16_t* bench_read_wav(const char* pPath, uint32_t* pLength)
+{
+    FILE* pWav = fopen(pPath, "rb");
+    uint8_t header[12];
+    uint8_t chunk[8];
+    uint32_t channels = 0;
+    int16_t* pSamples = NULL;
+
+    if (pWav == NULL)
+    {
+        fprintf(stderr, "Cannot read %s, using the synthetic signals only\n", pPath);
+        return NULL;
+    }
+
+    if ((fread(header, 1, sizeof(header), pWav) != sizeof(header)) ||
+        (memcmp(header, "RIFF", 4) != 0) || (memcmp(&header[8], "WAVE", 4) != 0))
+    {
+        goto invalid;
+    }
+
+    // Walk the chunks up to the samples, the format has to come first
+    while (fread(chunk, 1, sizeof(chunk), pWav) == sizeof(chunk))
+    {
+        const uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t) chunk[7] << 24);
+
+        if (memcmp(chunk, "fmt ", 4) == 0)
+        {
+            uint8_t format[16];
+
+            if ((size < sizeof(format)) || (fread(format, 1, sizeof(format), pWav) != sizeof(format)))
+            {
+                goto invalid;
+            }
+            // PCM or extensible, 16 bits
+            if ((((format[0] | (format[1] << 8)) != 1) && ((format[0] | (format[1] << 8)) != 0xFFFE)) ||
+                ((format[14] | (format[15] << 8)) != 16))
+            {
+                goto invalid;
+            }
+            channels = format[2] | (format[3] << 8);
+            fseek(pWav, (long) ((size - sizeof(format)) + (size & 1)), SEEK_CUR);
+        }
+        else if ((memcmp(chunk, "data", 4) == 0) && (channels > 0))
+        {
+            uint32_t length = size / (2 * channels);
+            uint8_t frame[2 * 8];
+
+            if ((channels > 8) || (length == 0))
+            {
+                goto invalid;
+            }
+            length = (length < BENCH_WAV_SAMPLES_MAX) ? length : BENCH_WAV_SAMPLES_MAX;
+            pSamples = malloc(length * sizeof(int16_t));
+            for (uint32_t sample = 0; (pSamples != NULL) && (sample < length); sample++)
+            {
+                if (fread(frame, 2, channels, pWav) != channels)
+                {
+                    length = sample;
+                    break;
+                }
+                pSamples[sample] = (int16_t) (frame[0] | (frame[1] << 8));
+            }
+            fclose(pWav);
+            *pLength = length;
+            return pSamples;
+        }
+        else
+        {
+            fseek(pWav, (long) (size + (size & 1)), SEEK_CUR);
+        }
+    }
+
+invalid:
+    fprintf(stderr, "%s is not a 16-bit PCM WAV file, using the synthetic signals only\n", pPath);
+    fclose(pWav);
+    return NULL;
+}
@@ -0,0 +1,314 @@
+/**
+ *******************************************************************************
+ * @file:    Eq_ARM_coeffs.h
+ * @brief:   Q31 coefficients of the equalizer bank for every sample rate that
+ *           ARM_Equalizer_set_rate() in Eq_ARM.c can switch to (EQ_MULTI_RATE).
+ *           Generated by Eq_SciPy_ARM.py (GENERATE_RATE_TABLE), do not edit.
+ *******************************************************************************
+ */
+
+#ifndef EQ_ARM_COEFFS_H
+#define EQ_ARM_COEFFS_H
+
+// Layout of the tables, checked against the defines of Eq_ARM.c
+#define EQ_RATE_COUNT           7
+#define EQ_RATE_STAGES          3
+#define EQ_RATE_BANDS           6
+#define EQ_RATE_COUPLED_BANDS   3
+#define EQ_RATE_POSTSHIFT       4
+
+// Sample rate of every entry of the tables [Hz]
+const uint32_t EQ_RATE_HZ[EQ_RATE_COUNT] =
+{
+    8000, 16000, 22050, 32000, 44100, 48000, 96000
+};
+
+// Rates * 3 stages * 6 bands * 5 coefficients for each biquad
+const q31_t EQ_RATE_BIQUAD_COEFF[EQ_RATE_COUNT * EQ_RATE_STAGES * EQ_RATE_BANDS * 5] =
+{
+    // 8000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    2721, 5441, 2721, 260375768, -126963382,
+    134217728, 0, -134217728, 262193941, -129474301,
+    134217728, -268435456, 134217728, 265393561, -131620458,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    20635, 41271, 20635, 251164150, -120080476,
+    134217728, 0, -134217728, 253261157, -124917151,
+    134217728, -268435456, 134217728, 261522959, -129065288,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    149046, 298093, 149046, 229631975, -107282897,
+    134217728, 0, -134217728, 228128773, -116401482,
+    134217728, -268435456, 134217728, 251380082, -124047183,
+    // Bandpass #4: 565.7 Hz to 1131.4 Hz
+    988093, 1976186, 988093, 176457518, -84757405,
+    134217728, 0, -134217728, 154862258, -101974490,
+    134217728, -268435456, 134217728, 222216381, -114157820,
+    // Bandpass #5: 1131.4 Hz to 2262.7 Hz
+    5760975, 0, -5760975, 47472643, -47645430,
+    134217728, 268435456, 134217728, -34439088, -85267947,
+    134217728, -268435456, 134217728, 136338823, -93133606,
+    // Bandpass #6: 2262.7 Hz to 3600.0 Hz
+    8631206, -17262412, 8631206, -131210503, -35741896,
+    134217728, 0, -134217728, -51038181, -66533910,
+    134217728, 268435456, 134217728, -228079052, -106924692,
+
+    // 16000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    349, 699, 349, 264555166, -130541571,
+    134217728, 0, -134217728, 265663083, -131823455,
+    134217728, -268435456, 134217728, 267019283, -132913273,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    2721, 5441, 2721, 260375768, -126963382,
+    134217728, 0, -134217728, 262193941, -129474301,
+    134217728, -268435456, 134217728, 265393561, -131620458,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    20635, 41271, 20635, 251164150, -120080476,
+    134217728, 0, -134217728, 253261157, -124917151,
+    134217728, -268435456, 134217728, 261522959, -129065288,
+    // Bandpass #4: 565.7 Hz to 1131.4 Hz
+    149046, 298093, 149046, 229631975, -107282897,
+    134217728, 0, -134217728, 228128773, -116401482,
+    134217728, -268435456, 134217728, 251380082, -124047183,
+    // Bandpass #5: 1131.4 Hz to 2262.7 Hz
+    988093, 1976186, 988093, 176457518, -84757405,
+    134217728, 0, -134217728, 154862258, -101974490,
+    134217728, -268435456, 134217728, 222216381, -114157820,
+    // Bandpass #6: 2262.7 Hz to 4525.5 Hz
+    5760975, 0, -5760975, 47472643, -47645430,
+    134217728, 268435456, 134217728, -34439088, -85267947,
+    134217728, -268435456, 134217728, 136338823, -93133606,
+
+    // 22050 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    135, 269, 135, 265650079, -131540242,
+    134217728, 0, -134217728, 266494100, -132475962,
+    134217728, -268435456, 134217728, 267428802, -133269978,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    1055, 2110, 1055, 262705584, -128915113,
+    134217728, 0, -134217728, 264182509, -130757728,
+    134217728, -268435456, 134217728, 266311488, -132328521,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    8116, 16233, 8116, 256356386, -123813872,
+    134217728, 0, -134217728, 258484594, -127394172,
+    134217728, -268435456, 134217728, 263748395, -130462759,
+    // Bandpass #4: 565.7 Hz to 1131.4 Hz
+    60187, 120374, 60187, 241934339, -114156198,
+    134217728, 0, -134217728, 243054193, -120972909,
+    134217728, -268435456, 134217728, 257335300, -126788236,
+    // Bandpass #5: 1131.4 Hz to 2262.7 Hz
+    417419, 834838, 417419, 207101522, -96673876,
+    134217728, 0, -134217728, 198306565, -109444853,
+    134217728, -268435456, 134217728, 239612788, -119579840,
+    // Bandpass #6: 2262.7 Hz to 4525.5 Hz
+    2594062, 5188123, 2594062, 120424838, -67002277,
+    134217728, 0, -134217728, 72211002, -92229281,
+    134217728, -268435456, 134217728, 187170050, -105055915,
+
+    // 32000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    44, 89, 44, 266533406, -132367065,
+    134217728, 0, -134217728, 267137814, -133015050,
+    134217728, -268435456, 134217728, 267753703, -133563974,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    349, 699, 349, 264555166, -130541571,
+    134217728, 0, -134217728, 265663083, -131823455,
+    134217728, -268435456, 134217728, 267019283, -132913273,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    2721, 5441, 2721, 260375768, -126963382,
+    134217728, 0, -134217728, 262193941, -129474301,
+    134217728, -268435456, 134217728, 265393561, -131620458,
+    // Bandpass #4: 565.7 Hz to 1131.4 Hz
+    20635, 41271, 20635, 251164150, -120080476,
+    134217728, 0, -134217728, 253261157, -124917151,
+    134217728, -268435456, 134217728, 261522959, -129065288,
+    // Bandpass #5: 1131.4 Hz to 2262.7 Hz
+    149046, 298093, 149046, 229631975, -107282897,
+    134217728, 0, -134217728, 228128773, -116401482,
+    134217728, -268435456, 134217728, 251380082, -124047183,
+    // Bandpass #6: 2262.7 Hz to 4525.5 Hz
+    988093, 1976186, 988093, 176457518, -84757405,
+    134217728, 0, -134217728, 154862258, -101974490,
+    134217728, -268435456, 134217728, 222216381, -114157820,
+
+    // 44100 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    17, 34, 17, 267062928, -132872309,
+    134217728, 0, -134217728, 267511606, -133343942,
+    134217728, -268435456, 134217728, 267946014, -133743038,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    135, 269, 135, 265650079, -131540242,
+    134217728, 0, -134217728, 266494100, -132475962,
+    134217728, -268435456, 134217728, 267428802, -133269978,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    1055, 2110, 1055, 262705584, -128915113,
+    134217728, 0, -134217728, 264182509, -130757728,
+    134217728, -268435456, 134217728, 266311488, -132328521,
+    // Bandpass #4: 565.7 Hz to 1131.4 Hz
+    8116, 16233, 8116, 256356386, -123813872,
+    134217728, 0, -134217728, 258484594, -127394172,
+    134217728, -268435456, 134217728, 263748395, -130462759,
+    // Bandpass #5: 1131.4 Hz to 2262.7 Hz
+    60187, 120374, 60187, 241934339, -114156198,
+    134217728, 0, -134217728, 243054193, -120972909,
+    134217728, -268435456, 134217728, 257335300, -126788236,
+    // Bandpass #6: 2262.7 Hz to 4525.5 Hz
+    417419, 834838, 417419, 207101522, -96673876,
+    134217728, 0, -134217728, 198306565, -109444853,
+    134217728, -268435456, 134217728, 239612788, -119579840,
+
+    // 48000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    13, 26, 13, 267175958, -132981122,
+    134217728, 0, -134217728, 267590179, -133414721,
+    134217728, -268435456, 134217728, 267986819, -133781545,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    104, 209, 104, 265882388, -131755805,
+    134217728, 0, -134217728, 266665773, -132616610,
+    134217728, -268435456, 134217728, 267514734, -133346741,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    821, 1642, 821, 263194712, -129338220,
+    134217728, 0, -134217728, 264582966, -131035315,
+    134217728, -268435456, 134217728, 266500546, -132481098,
+    // Bandpass #4: 565.7 Hz to 1131.4 Hz
+    6334, 12668, 6334, 257428857, -124629770,
+    134217728, 0, -134217728, 259505777, -127934003,
+    134217728, -268435456, 134217728, 264194477, -130764492,
+    // Bandpass #5: 1131.4 Hz to 2262.7 Hz
+    47245, 94491, 47245, 244426316, -115679436,
+    134217728, 0, -134217728, 245908759, -121987728,
+    134217728, -268435456, 134217728, 258492189, -127380955,
+    // Bandpass #6: 2262.7 Hz to 4525.5 Hz
+    331056, 662112, 331056, 213243826, -99369262,
+    134217728, 0, -134217728, 206676140, -111193541,
+    134217728, -268435456, 134217728, 242917407, -120744277,
+
+    // 96000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    2, 3, 2, 267809993, -133598001,
+    134217728, 0, -134217728, 268022761, -133815617,
+    134217728, -268435456, 134217728, 268214074, -133999462,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    13, 26, 13, 267175958, -132981122,
+    134217728, 0, -134217728, 267590179, -133414721,
+    134217728, -268435456, 134217728, 267986819, -133781545,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    104, 209, 104, 265882388, -131755805,
+    134217728, 0, -134217728, 266665773, -132616610,
+    134217728, -268435456, 134217728, 267514734, -133346741,
+    // Bandpass #4: 565.7 Hz to 1131.4 Hz
+    821, 1642, 821, 263194712, -129338220,
+    134217728, 0, -134217728, 264582966, -131035315,
+    134217728, -268435456, 134217728, 266500546, -132481098,
+    // Bandpass #5: 1131.4 Hz to 2262.7 Hz
+    6334, 12668, 6334, 257428857, -124629770,
+    134217728, 0, -134217728, 259505777, -127934003,
+    134217728, -268435456, 134217728, 264194477, -130764492,
+    // Bandpass #6: 2262.7 Hz to 4525.5 Hz
+    47245, 94491, 47245, 244426316, -115679436,
+    134217728, 0, -134217728, 245908759, -121987728,
+    134217728, -268435456, 134217728, 258492189, -127380955,
+};
+
+// Rates * 3 stages * 3 low bands * 6 coefficients for each coupled-form section
+const q31_t EQ_RATE_BIQUAD_COEFF_COUPLED[EQ_RATE_COUNT * EQ_RATE_STAGES * EQ_RATE_COUPLED_BANDS * 6] =
+{
+    // 8000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    2721, 4194304, 130187884, 9583915, 343003, 4725251,
+    134217728, 268435456, 131096971, 13832241, 131096971, -36845575,
+    134217728, 4194304, 132696780, 7573862, -97340650, -232589825,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    20635, 8388608, 125582075, 18602987, 1278177, 8879422,
+    134217728, 268435456, 126630578, 27033179, 126630578, -50121517,
+    134217728, 8388608, 130761480, 14976151, -110599947, -226856092,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    149046, 16777216, 114815988, 34879158, 4424760, 15486310,
+    134217728, 268435456, 114064387, 51112212, 114064387, -74504430,
+    134217728, 16777216, 125690041, 29177810, -136442988, -213483648,
+
+    // 16000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    349, 2097152, 132277583, 4861491, 88811, 2433400,
+    134217728, 134217728, 132831541, 6987581, 265663083, -59964447,
+    134217728, 2097152, 133509641, 3806995, -90635099, -235218790,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    2721, 4194304, 130187884, 9583915, 343003, 4725251,
+    134217728, 268435456, 131096971, 13832241, 131096971, -36845575,
+    134217728, 4194304, 132696780, 7573862, -97340650, -232589825,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    20635, 8388608, 125582075, 18602987, 1278177, 8879422,
+    134217728, 268435456, 126630578, 27033179, 126630578, -50121517,
+    134217728, 8388608, 130761480, 14976151, -110599947, -226856092,
+
+    // 22050 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    135, 1048576, 132825039, 3541365, 68516, 2582835,
+    134217728, 134217728, 133247050, 5083920, 266494100, -56151230,
+    134217728, 2097152, 133714401, 2766323, -64425847, -171183601,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    1055, 2097152, 131352792, 7009819, 267198, 5057931,
+    134217728, 134217728, 132091254, 10094836, 264182509, -66192734,
+    134217728, 4194304, 133155744, 5511917, -67966962, -169833728,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    8116, 4194304, 128178193, 13724702, 1015522, 9681077,
+    134217728, 268435456, 129242297, 19874232, 129242297, -42915176,
+    134217728, 8388608, 131874198, 10936690, -74992976, -166952244,
+
+    // 32000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    44, 1048576, 133266703, 2447994, 22594, 1234258,
+    134217728, 134217728, 133568907, 3510676, 267137814, -53001299,
+    134217728, 1048576, 133876851, 1908341, -87264410, -236473826,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    349, 2097152, 132277583, 4861491, 88811, 2433400,
+    134217728, 134217728, 132831541, 6987581, 265663083, -59964447,
+    134217728, 2097152, 133509641, 3806995, -90635099, -235218790,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    2721, 4194304, 130187884, 9583915, 343003, 4725251,
+    134217728, 268435456, 131096971, 13832241, 131096971, -36845575,
+    134217728, 4194304, 132696780, 7573862, -97340650, -232589825,
+
+    // 44100 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    17, 524288, 133531464, 1779745, 17347, 1304800,
+    134217728, 134217728, 133755803, 2550706, 267511606, -51079886,
+    134217728, 1048576, 133973007, 1385687, -62648557, -171835829,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    135, 1048576, 132825039, 3541365, 68516, 2582835,
+    134217728, 134217728, 133247050, 5083920, 266494100, -56151230,
+    134217728, 2097152, 133714401, 2766323, -64425847, -171183601,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    1055, 2097152, 131352792, 7009819, 267198, 5057931,
+    134217728, 134217728, 132091254, 10094836, 264182509, -66192734,
+    134217728, 4194304, 133155744, 5511917, -67966962, -169833728,
+
+    // 48000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    13, 524288, 133587979, 1635816, 13467, 1102299,
+    134217728, 134217728, 133795089, 2344104, 267590179, -50666426,
+    134217728, 524288, 133993410, 1273286, -114851024, -315844489,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    104, 1048576, 132941194, 3256340, 53245, 2183853,
+    134217728, 134217728, 133332886, 4673495, 266665773, -55329358,
+    134217728, 1048576, 133757367, 2542319, -117852360, -314746511,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    821, 2097152, 131597356, 6451191, 208075, 4284232,
+    134217728, 134217728, 132291483, 9285779, 264582966, -64570531,
+    134217728, 2097152, 133250273, 5067213, -123834220, -312480112,
+
+    // 96000 Hz
+    // Bandpass #1: 70.7 Hz to 141.4 Hz
+    2, 262144, 133904996, 819814, 3386, 553734,
+    134217728, 134217728, 134011380, 1173854, 268022761, -48324888,
+    134217728, 262144, 134107037, 637168, -113347806, -316384674,
+    // Bandpass #2: 141.4 Hz to 282.8 Hz
+    13, 524288, 133587979, 1635816, 13467, 1102299,
+    134217728, 134217728, 133795089, 2344104, 267590179, -50666426,
+    134217728, 524288, 133993410, 1273286, -114851024, -315844489,
+    // Bandpass #3: 282.8 Hz to 565.7 Hz
+    104, 1048576, 132941194, 3256340, 53245, 2183853,
+    134217728, 134217728, 133332886, 4673495, 266665773, -55329358,
+    134217728, 1048576, 133757367, 2542319, -117852360, -314746511,
+};
+
+#endif // EQ_ARM_COEFFS_H
@@ -0,0 +1,51 @@
+/**
+ *******************************************************************************
+ * @file:    Eq_ARM_gains.h
+ * @brief:   Q4.27 band gains of the mix in Eq_ARM.c for every 0.5 dB step
+ *           from -24.0 dB to +24.0 dB, used by ARM_Equalizer_apply_preset() (EQ_PRESETS).
+ *           Generated by Eq_SciPy_ARM.py (GENERATE_GAIN_TABLE), do not edit.
+ *******************************************************************************
+ */
+
+#ifndef EQ_ARM_GAINS_H
+#define EQ_ARM_GAINS_H
+
+// Layout of the table, entry 0 is the gain of EQ_GAIN_MIN_STEP
+#define EQ_GAIN_STEPS_PER_DB    2
+#define EQ_GAIN_MIN_STEP        (-48)
+#define EQ_GAIN_MAX_STEP        48
+#define EQ_GAIN_STEP_COUNT      97
+#define EQ_GAIN_FRACTION_BITS   27
+
+// Band gain of every step
+const q31_t EQ_GAIN_TABLE[EQ_GAIN_STEP_COUNT] =
+{
+    // -24.0 dB
+    8468566, 8970360, 9501887, 10064910, 10661293, 11293014, 11962168, 12670971,
+    // -20.0 dB
+    13421773, 14217063, 15059477, 15951807, 16897011, 17898222, 18958758, 20082135,
+    // -16.0 dB
+    21272076, 22532526, 23867662, 25281910, 26779957, 28366770, 30047606, 31828039,
+    // -12.0 dB
+    33713969, 35711647, 37827695, 40069127, 42443372, 44958300, 47622247, 50444043,
+    // -8.0 dB
+    53433040, 56599147, 59952857, 63505287, 67268212, 71254104, 75476175, 79948420,
+    // -4.0 dB
+    84685661, 89703602, 95018875, 100649097, 106612931, 112930144, 119621676, 126709706,
+    // +0.0 dB
+    134217728, 142170628, 150594768, 159518069, 168970108, 178982217, 189587580, 200821350,
+    // +4.0 dB
+    212720763, 225325261, 238676622, 252819101, 267799575, 283667697, 300476065, 318280391,
+    // +8.0 dB
+    337139690, 357116472, 378276954, 400691272, 424433723, 449583002, 476222470, 504440425,
+    // +12.0 dB
+    534330399, 565991466, 599528569, 635052870, 672682118, 712541039, 754761750, 799484196,
+    // +16.0 dB
+    846856612, 897036021, 950188747, 1006490970, 1066129310, 1129301443, 1196216760, 1267097059,
+    // +20.0 dB
+    1342177280, 1421706284, 1505947677, 1595180687, 1689701085, 1789822169, 1895875800, 2008213503,
+    // +24.0 dB
+    2127207634,
+};
+
+#endif // EQ_ARM_GAINS_H
@@ -0,0 +1,413 @@
+/**
+ *******************************************************************************
+ * @file:    Eq_ARM_module.c
+ * @brief:   Python extension module "eq_arm" around the equalizer engine of
+ *           Eq_ARM.c, so that Python runs exactly the code of the target
+ *           instead of emulating it with cmsisdsp calls. Eq_ARM.c is compiled
+ *           in here as it is, only its main() is left out (EQ_NO_MAIN).
+ *
+ * @Note:    Build it with setup.py, e.g. "python setup.py build_ext --inplace",
+ *           and use it on NumPy arrays (or any other buffer) without a copy:
+ *
+ *               import numpy as np
+ *               import eq_arm
+ *
+ *               out = np.empty_like(samples)  # int16, or int32 full scale (Q31)
+ *               eq_arm.process(samples, out)  # out may be samples itself
+ *
+ *           The engine is a single instance with state, so consecutive calls
+ *           continue the same stream until reset(). The GIL is released while
+ *           the samples are processed, and calls from several threads are
+ *           serialized on the engine.
+ *
+ *******************************************************************************
+ */
+
+//******************************************************************************
+//  Include Files
+//******************************************************************************
+
+// PYTHON DEFINITIONS, before any standard header
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <pythread.h>
+
+// THE EQUALIZER ENGINE, without its main()
+#define EQ_NO_MAIN 1
+#include "Eq_ARM.c"
+
+//******************************************************************************
+//  Static Variables
+//******************************************************************************
+
+// Serializes the threads on the single engine instance of Eq_ARM.c
+static PyThread_type_lock engineLock;
+
+#if EQ_PRESETS
+// Serializes the threads on the control side of the presets, which may run while
+// another thread processes
+static PyThread_type_lock presetLock;
+#endif
+
+//******************************************************************************
+//  Functions
+//******************************************************************************
+
+/**
+ *******************************************************************************
+ * @brief:     Checks the sample format of a buffer, native int16 or int32
+ * @parameter: const Py_buffer* view - Buffer to check
+ * @return:    Py_ssize_t - Bytes per sample, 0 if the format is not supported
+ *******************************************************************************
+ */
+static Py_ssize_t eq_arm_sample_size(const Py_buffer* view)
+{
+    const char* format = (view->format != NULL) ? view->format : "B";
+
+    // Native byte order only, with or without the prefix
+    if ((format[0] == '@') || (format[0] == '='))
+    {
+        format++;
+    }
+    if (format[1] != '\0')
+    {
+        return 0;
+    }
+    if ((format[0] == 'h') && (view->itemsize == 2))
+    {
+        return 2;
+    }
+    if (((format[0] == 'i') || (format[0] == 'l')) && (view->itemsize == 4))
+    {
+        return 4;
+    }
+    return 0;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     Runs the equalizer over all samples, STREAM_SAMPLES_PER_TRANSFER
+ *             at a time as main() of Eq_ARM.c does. int32 samples are passed as
+ *             they are to the Q31 interface of the engine (ARM_Equalizer_q31()),
+ *             so they keep all of their bits.
+ * @parameter: const void* pSrc    - Samples to process
+ *             void* pDest         - Processed samples, may be pSrc
+ *             Py_ssize_t count    - Number of samples
+ *             Py_ssize_t size     - Bytes per sample, 2 or 4
+ * @return:    N/A
+ *******************************************************************************
+ */
+static void eq_arm_run(const void* pSrc, void* pDest, Py_ssize_t count, Py_ssize_t size)
+{
+    for (Py_ssize_t offset = 0; offset < count; offset += STREAM_SAMPLES_PER_TRANSFER)
+    {
+        const uint16_t blocksize = (uint16_t) ((count - offset < STREAM_SAMPLES_PER_TRANSFER) ?
+                                               (count - offset) : STREAM_SAMPLES_PER_TRANSFER);
+
+        if (size == 2)
+        {
+            ARM_Equalizer((int16_t*) pSrc + offset, (int16_t*) pDest + offset, blocksize);
+        }
+        else
+        {
+            ARM_Equalizer_q31((const q31_t*) pSrc + offset, (q31_t*) pDest + offset, blocksize);
+        }
+    }
+}
+
+/**
+ *******************************************************************************
+ * @brief:     process(src, dst) -> dst. Equalizes the samples of src into dst,
+ *             both C-contiguous buffers of the same length and type, int16 or
+ *             int32. dst may be src for in-place processing. With a stream rate
+ *             other than the bank rate the length has to be a multiple of the
+ *             SRC decimation.
+ * @parameter: PyObject* args - src and dst
+ * @return:    PyObject* - dst, NULL with an exception set on error
+ *******************************************************************************
+ */
+static PyObject* eq_arm_process(PyObject* self, PyObject* args)
+{
+    PyObject* srcObject;
+    PyObject* destObject;
+    Py_buffer src;
+    Py_buffer dest;
+    Py_ssize_t size;
+    Py_ssize_t count;
+
+    UNUSED(self);
+
+    if (!PyArg_ParseTuple(args, "OO:process", &srcObject, &destObject))
+    {
+        return NULL;
+    }
+    if (PyObject_GetBuffer(srcObject, &src, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)
+    {
+        return NULL;
+    }
+    if (PyObject_GetBuffer(destObject, &dest, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | PyBUF_WRITABLE) < 0)
+    {
+        PyBuffer_Release(&src);
+        return NULL;
+    }
+
+    size = eq_arm_sample_size(&src);
+    if ((size == 0) || (eq_arm_sample_size(&dest) != size) || (src.len != dest.len))
+    {
+        PyErr_SetString(PyExc_TypeError, "src and dst have to be int16 or int32 buffers of the same type and length");
+        goto error;
+    }
+    count = src.len / size;
+    if ((count % SRC_DECIMATION) != 0)
+    {
+        PyErr_Format(PyExc_ValueError, "the number of samples has to be a multiple of %d", SRC_DECIMATION);
+        goto error;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(engineLock, WAIT_LOCK);
+    eq_arm_run(src.buf, dest.buf, count, size);
+    PyThread_release_lock(engineLock);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&src);
+    PyBuffer_Release(&dest);
+    Py_INCREF(destObject);
+    return destObject;
+
+error:
+    PyBuffer_Release(&src);
+    PyBuffer_Release(&dest);
+    return NULL;
+}
+
+/**
+ *******************************************************************************
+ * @brief:     reset(). Restarts the engine as ARM_Equalizer_init() does, the
+ *             filter states are cleared and the band gains are back at their
+ *             defaults.
+ * @parameter: N/A
+ * @return:    PyObject* - None
+ *******************************************************************************
+ */
+static PyObject* eq_arm_reset(PyObject* self, PyObject* args)
+{
+    UNUSED(self);
+    UNUSED(args);
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(engineLock, WAIT_LOCK);
+    ARM_Equalizer_init();
+    PyThread_release_lock(engineLock);
+    Py_END_ALLOW_THREADS
+
+    Py_RETURN_NONE;
+}
+
+#if EQ_PRESETS
+/**
+ *******************************************************************************
+ * @brief:     apply_preset(steps). Applies band gains given in steps of the
+ *             gain table (ARM_Equalizer_apply_preset()), they take effect with
+ *             the next processed block, also of a process() call that is
+ *             running in another thread.
+ * @parameter: PyObject* args - Sequence of NUMBER_OF_BANDS integer steps
+ * @return:    PyObject* - None, NULL with an exception set on error
+ *******************************************************************************
+ */
+static PyObject* eq_arm_apply_preset(PyObject* self, PyObject* args)
+{
+    PyObject* stepsObject;
+    PyObject* sequence;
+    int8_t steps[NUMBER_OF_BANDS];
+    arm_status status;
+
+    UNUSED(self);
+
+    if (!PyArg_ParseTuple(args, "O:apply_preset", &stepsObject))
+    {
+        return NULL;
+    }
+    sequence = PySequence_Fast(stepsObject, "steps has to be a sequence");
+    if (sequence == NULL)
+    {
+        return NULL;
+    }
+    if (PySequence_Fast_GET_SIZE(sequence) != NUMBER_OF_BANDS)
+    {
+        Py_DECREF(sequence);
+        PyErr_Format(PyExc_ValueError, "steps needs %d entries", NUMBER_OF_BANDS);
+        return NULL;
+    }
+    for (uint32_t band = 0; band < NUMBER_OF_BANDS; band++)
+    {
+        const long step = PyLong_AsLong(PySequence_Fast_GET_ITEM(sequence, band));
+
+        if ((step == -1) && PyErr_Occurred())
+        {
+            Py_DECREF(sequence);
+            return NULL;
+        }
+        steps[band] = (int8_t) ((step < EQ_GAIN_MIN_STEP) ? (EQ_GAIN_MIN_STEP - 1) :
+                                (step > EQ_GAIN_MAX_STEP) ? (EQ_GAIN_MAX_STEP + 1) : step);
+    }
+    Py_DECREF(sequence);
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(presetLock, WAIT_LOCK);
+    status = ARM_Equalizer_apply_preset(steps);
+    PyThread_release_lock(presetLock);
+    Py_END_ALLOW_THREADS
+
+    if (status != ARM_MATH_SUCCESS)
+    {
+        PyErr_Format(PyExc_ValueError, "steps have to be within %d..%d", EQ_GAIN_MIN_STEP, EQ_GAIN_MAX_STEP);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+#endif
+
+#if EQ_MULTI_RATE
+/**
+ *******************************************************************************
+ * @brief:     set_rate(rate). Switches the bank to another rate of
+ *             Eq_ARM_coeffs.h (ARM_Equalizer_set_rate()).
+ * @parameter: PyObject* args - Sampling rate [Hz]
+ * @return:    PyObject* - None, NULL with an exception set on error
+ *******************************************************************************
+ */
+static PyObject* eq_arm_set_rate(PyObject* self, PyObject* args)
+{
+    unsigned int rate;
+    arm_status status;
+
+    UNUSED(self);
+
+    if (!PyArg_ParseTuple(args, "I:set_rate", &rate))
+    {
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(engineLock, WAIT_LOCK);
+    status = ARM_Equalizer_set_rate(rate);
+    PyThread_release_lock(engineLock);
+    Py_END_ALLOW_THREADS
+
+    if (status != ARM_MATH_SUCCESS)
+    {
+        PyErr_Format(PyExc_ValueError, "%u Hz is not in the rate table", rate);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+#endif
+
+#if EQ_RUNTIME_DESIGN
+/**
+ *******************************************************************************
+ * @brief:     retune(base_frequency). Designs the octave bands for a new first
+ *             band center on the fly (ARM_Equalizer_retune()).
+ * @parameter: PyObject* args - Center of the first band [Hz]
+ * @return:    PyObject* - None, NULL with an exception set on error
+ *******************************************************************************
+ */
+static PyObject* eq_arm_retune(PyObject* self, PyObject* args)
+{
+    double baseFrequency;
+    arm_status status;
+
+    UNUSED(self);
+
+    if (!PyArg_ParseTuple(args, "d:retune", &baseFrequency))
+    {
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(engineLock, WAIT_LOCK);
+    status = ARM_Equalizer_retune(baseFrequency);
+    PyThread_release_lock(engineLock);
+    Py_END_ALLOW_THREADS
+
+    if (status != ARM_MATH_SUCCESS)
+    {
+        PyErr_Format(PyExc_ValueError, "the bands of %g Hz do not fit the bank", baseFrequency);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+#endif
+
+//******************************************************************************
+//  Module Definition
+//******************************************************************************
+
+static PyMethodDef eqArmMethods[] =
+{
+    { "process", eq_arm_process, METH_VARARGS,
+      "process(src, dst) -> dst\n\nEqualizes the int16 or int32 (Q31) samples of src into dst (may be src)." },
+    { "reset", eq_arm_reset, METH_NOARGS,
+      "reset()\n\nRestarts the engine, clears the filter states." },
+#if EQ_PRESETS
+    { "apply_preset", eq_arm_apply_preset, METH_VARARGS,
+      "apply_preset(steps)\n\nSets the band gains in steps of the gain table, 0 is 0 dB." },
+#endif
+#if EQ_MULTI_RATE
+    { "set_rate", eq_arm_set_rate, METH_VARARGS,
+      "set_rate(rate)\n\nSwitches the bank to another rate of the rate table." },
+#endif
+#if EQ_RUNTIME_DESIGN
+    { "retune", eq_arm_retune, METH_VARARGS,
+      "retune(base_frequency)\n\nDesigns the octave bands for a new first band center." },
+#endif
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef eqArmModule =
+{
+    PyModuleDef_HEAD_INIT,
+    "eq_arm",
+    "Equalizer engine of Eq_ARM.c",
+    -1,
+    eqArmMethods,
+    NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_eq_arm(void)
+{
+    PyObject* module = PyModule_Create(&eqArmModule);
+
+    if (module == NULL)
+    {
+        return NULL;
+    }
+
+    engineLock = PyThread_allocate_lock();
+    if (engineLock == NULL)
+    {
+        Py_DECREF(module);
+        return PyErr_NoMemory();
+    }
+#if EQ_PRESETS
+    presetLock = PyThread_allocate_lock();
+    if (presetLock == NULL)
+    {
+        PyThread_free_lock(engineLock);
+        engineLock = NULL;
+        Py_DECREF(module);
+        return PyErr_NoMemory();
+    }
+#endif
+
+    // Configuration the engine was built with
+    PyModule_AddIntConstant(module, "SAMPLE_RATE_HZ", SAMPLE_RATE_HZ);
+    PyModule_AddIntConstant(module, "STREAM_SAMPLE_RATE_HZ", STREAM_SAMPLE_RATE_HZ);
+    PyModule_AddIntConstant(module, "NUMBER_OF_BANDS", NUMBER_OF_BANDS);
+    PyModule_AddIntConstant(module, "SAMPLES_PER_TRANSFER", STREAM_SAMPLES_PER_TRANSFER);
+
+    ARM_Equalizer_init();
+
+    return module;
+}
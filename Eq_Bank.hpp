@@ -0,0 +1,508 @@
+/**
+ *******************************************************************************
+ * @file:    Eq_Bank.hpp
+ * @brief:   Header-only C++17 version of the equalizer bank of Eq_ARM.c. The
+ *           Butterworth octave bands are designed at compile time (constexpr)
+ *           from the same band edges as Eq_SciPy_ARM.py, so there is no table
+ *           to paste and keep in sync. Every band and stage of the given
+ *           configuration is instantiated as its own kernel: the stage and
+ *           band loops are unrolled, the coefficients are constants the
+ *           compiler folds into the code, and the state of a whole block stays
+ *           in registers.
+ *
+ * @Note:    Usage, e.g. the bank of Eq_ARM.c on Q31 samples:
+ *
+ *               static eq::EqualizerBank<6, 3, int32_t, 16000> bank;
+ *               bank.process(pSrc, pDst, blocksize);
+ *
+ *           SampleT is int32_t for Q31 samples or a floating point type. With
+ *           Q31 the coefficients are quantized like Eq_SciPy_ARM.py (scaled by
+ *           2^-PostShift) and the kernels follow the CMSIS DF1 functions: bands
+ *           centered below FS / 32 run on the 32x64-bit kernel, as bands 1-3 of
+ *           Eq_ARM.c do, the others on the 32x32-bit kernel. Like the input of
+ *           Eq_ARM.c the Q31 input needs a few bits of headroom for the band
+ *           gains and the filter overshoot.
+ *
+ *******************************************************************************
+ */
+
+#ifndef EQ_BANK_HPP
+#define EQ_BANK_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace eq
+{
+
+//******************************************************************************
+//  Compile-time math
+//******************************************************************************
+
+// The <cmath> functions are not constexpr before C++26, these are accurate to a
+// few ulp over the ranges the design needs
+namespace detail
+{
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kSqrt2 = 1.41421356237309504880;
+
+constexpr double sqrt(double x)
+{
+    double scale = 1.0;
+    double root = 1.5;
+
+    if (x <= 0.0)
+    {
+        return 0.0;
+    }
+
+    // Bring x into [1, 4) by powers of 4, where Newton converges in a few steps
+    while (x >= 4.0)
+    {
+        x *= 0.25;
+        scale *= 2.0;
+    }
+    while (x < 1.0)
+    {
+        x *= 4.0;
+        scale *= 0.5;
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        root = 0.5 * (root + x / root);
+    }
+
+    return root * scale;
+}
+
+// Taylor series, the design only needs arguments within -pi..pi
+constexpr double sin(double x)
+{
+    double term = x;
+    double sum = x;
+
+    for (int k = 1; k < 30; k++)
+    {
+        term *= -x * x / ((2.0 * k) * (2.0 * k + 1.0));
+        sum += term;
+    }
+
+    return sum;
+}
+
+constexpr double cos(double x)
+{
+    double term = 1.0;
+    double sum = 1.0;
+
+    for (int k = 1; k < 30; k++)
+    {
+        term *= -x * x / ((2.0 * k - 1.0) * (2.0 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+constexpr double tan(double x)
+{
+    return sin(x) / cos(x);
+}
+
+// Round half to even, like numpy.round() and nearbyint()
+constexpr double round(double x)
+{
+    const double whole = static_cast<double>(static_cast<int64_t>(x));
+    const double fraction = x - whole;
+    const bool odd = (static_cast<int64_t>(whole) % 2) != 0;
+
+    if ((fraction > 0.5) || ((fraction == 0.5) && odd))
+    {
+        return whole + 1.0;
+    }
+    if ((fraction < -0.5) || ((fraction == -0.5) && odd))
+    {
+        return whole - 1.0;
+    }
+    return whole;
+}
+
+struct Complex
+{
+    double re;
+    double im;
+};
+
+constexpr Complex operator+(Complex a, Complex b) { return { a.re + b.re, a.im + b.im }; }
+constexpr Complex operator-(Complex a, Complex b) { return { a.re - b.re, a.im - b.im }; }
+constexpr Complex operator*(Complex a, Complex b) { return { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re }; }
+constexpr Complex operator*(Complex a, double b) { return { a.re * b, a.im * b }; }
+
+constexpr Complex operator/(Complex a, Complex b)
+{
+    const double norm = b.re * b.re + b.im * b.im;
+    return { (a.re * b.re + a.im * b.im) / norm, (a.im * b.re - a.re * b.im) / norm };
+}
+
+constexpr double abs(Complex a)
+{
+    return sqrt(a.re * a.re + a.im * a.im);
+}
+
+// Principal square root, the upper half plane one for negative real numbers
+constexpr Complex sqrt(Complex a)
+{
+    const double magnitude = abs(a);
+    const double re = sqrt(0.5 * (magnitude + a.re));
+    const double im = sqrt(0.5 * (magnitude - a.re));
+
+    return { re, (a.im < 0.0) ? -im : im };
+}
+
+//******************************************************************************
+//  Compile-time Butterworth design
+//******************************************************************************
+
+// Second-order sections in the CMSIS DF1 layout {b0, b1, b2, -a1, -a2}
+template <std::size_t Stages>
+using Sections = std::array<std::array<double, 5>, Stages>;
+
+// Digital Butterworth bandpass of order Stages, the same steps as
+// eq_butter_bandpass_q31() in Eq_ARM.c and scipy.signal.butter(output='sos'):
+// buttap, lp2bp_zpk at the prewarped edges, bilinear_zpk and the 'nearest'
+// pairing of zpk2sos, the pole closest to the unit circle in the last section.
+// The zeros are Stages times z = 1 and Stages times z = -1.
+template <std::size_t Stages>
+constexpr Sections<Stages> butter_bandpass(double lowcut, double highcut, double fs)
+{
+    std::array<Complex, Stages> poles{};
+    std::array<Complex, Stages> sectionPole{};
+    std::array<double, Stages> sectionZeroSum{};
+    std::array<double, Stages> sectionZeroProduct{};
+    Sections<Stages> sections{};
+    Complex poleProduct{ 1.0, 0.0 };
+    std::size_t zerosPositive = Stages;
+    std::size_t zerosNegative = Stages;
+    std::size_t count = 0;
+    double gain = 1.0;
+
+    // Prewarped edges of the analog design, SciPy designs at fs = 2
+    const double warpedLow = 4.0 * tan(kPi * lowcut / fs);
+    const double warpedHigh = 4.0 * tan(kPi * highcut / fs);
+    const double bandwidth = warpedHigh - warpedLow;
+
+    for (std::size_t pole = 0; pole < Stages; pole++)
+    {
+        // Pole of the analog lowpass prototype and its lowpass to bandpass pair
+        const double angle = kPi * (2.0 * static_cast<double>(pole) - static_cast<double>(Stages) + 1.0) / (2.0 * static_cast<double>(Stages));
+        const Complex lowpass = Complex{ -cos(angle), -sin(angle) } * (0.5 * bandwidth);
+        const Complex offset = sqrt(lowpass * lowpass - Complex{ warpedLow * warpedHigh, 0.0 });
+
+        for (int sign = -1; sign <= 1; sign += 2)
+        {
+            // Bilinear transform, keeping the pole in the upper half of each pair
+            const Complex analog = lowpass + offset * static_cast<double>(sign);
+            const Complex digital = (Complex{ 4.0, 0.0 } + analog) / (Complex{ 4.0, 0.0 } - analog);
+
+            poleProduct = poleProduct * (Complex{ 4.0, 0.0 } - analog);
+            if ((digital.im > 0.0) && (count < Stages))
+            {
+                poles[count++] = digital;
+            }
+        }
+    }
+
+    // Gain of the bandpass, bw^N, through the bilinear transform of its N zeros at s = 0
+    for (std::size_t stage = 0; stage < Stages; stage++)
+    {
+        gain *= 4.0 * bandwidth;
+    }
+    gain = (Complex{ gain, 0.0 } / poleProduct).re;
+
+    // Pair the poles, the worst first into the last section, with the nearest zeros
+    for (std::size_t section = Stages; section-- > 0;)
+    {
+        std::size_t worst = 0;
+
+        for (std::size_t pole = 1; pole < count; pole++)
+        {
+            const double distance = 1.0 - abs(poles[pole]);
+            const double worstDistance = 1.0 - abs(poles[worst]);
+            if ((distance < 0.0 ? -distance : distance) < (worstDistance < 0.0 ? -worstDistance : worstDistance))
+            {
+                worst = pole;
+            }
+        }
+        sectionPole[section] = poles[worst];
+        sectionZeroSum[section] = 0.0;
+        sectionZeroProduct[section] = 1.0;
+
+        for (int zero = 0; zero < 2; zero++)
+        {
+            const bool positive = (zerosNegative == 0) ||
+                                  ((zerosPositive > 0) && (abs(poles[worst] - Complex{ 1.0, 0.0 }) <
+                                                           abs(poles[worst] + Complex{ 1.0, 0.0 })));
+
+            sectionZeroSum[section] += positive ? 1.0 : -1.0;
+            sectionZeroProduct[section] *= positive ? 1.0 : -1.0;
+            zerosPositive -= positive ? 1 : 0;
+            zerosNegative -= positive ? 0 : 1;
+        }
+
+        // Remove the pole, keeping the order of the others like numpy.delete
+        count--;
+        for (std::size_t pole = worst; pole < count; pole++)
+        {
+            poles[pole] = poles[pole + 1];
+        }
+    }
+
+    for (std::size_t section = 0; section < Stages; section++)
+    {
+        const double scale = (section == 0) ? gain : 1.0;
+        const Complex pole = sectionPole[section];
+
+        sections[section] = { scale, -scale * sectionZeroSum[section], scale * sectionZeroProduct[section],
+                              2.0 * pole.re, -(pole.re * pole.re + pole.im * pole.im) };
+    }
+
+    return sections;
+}
+
+} // namespace detail
+
+//******************************************************************************
+//  Equalizer bank
+//******************************************************************************
+
+/**
+ *******************************************************************************
+ * @brief:     Bank of Bands Butterworth octave bandpass filters of Stages
+ *             second-order sections each, centered at BaseHz * 2^band and
+ *             with edges a half octave either side (calculate_centers() in
+ *             Eq_SciPy_ARM.py). Edges above 0.9 of the Nyquist frequency are
+ *             limited as in the multi-rate table. The band outputs are scaled by
+ *             their gains and summed, like ARM_Equalizer_mix() without the block
+ *             floating point.
+ * @parameter: Bands     - Number of octave bands
+ *             Stages    - Second-order sections per band
+ *             SampleT   - int32_t for Q31 samples or a floating point type
+ *             FS        - Sampling rate [Hz]
+ *             BaseHz    - Center of the first band [Hz]
+ *             PostShift - Coefficient scaling 2^-PostShift of the Q31 kernels
+ *******************************************************************************
+ */
+template <std::size_t Bands, std::size_t Stages, typename SampleT, unsigned FS,
+          unsigned BaseHz = 100, unsigned PostShift = 4>
+class EqualizerBank
+{
+public:
+    static constexpr bool kFixedPoint = std::is_same<SampleT, int32_t>::value;
+
+    static_assert(kFixedPoint || std::is_floating_point<SampleT>::value,
+                  "SampleT has to be int32_t (Q31) or a floating point type");
+    static_assert((Bands > 0) && (Stages > 0), "The bank needs at least one band and one stage");
+
+    // Band gains of the mix, Q4.27 like Eq_ARM.c for Q31 samples
+    static constexpr int kGainFractionBits = 27;
+    using GainT = typename std::conditional<kFixedPoint, int32_t, SampleT>::type;
+    using CoeffT = typename std::conditional<kFixedPoint, int32_t, SampleT>::type;
+    static constexpr GainT kGainUnity = kFixedPoint ? static_cast<GainT>(int32_t(1) << kGainFractionBits)
+                                                    : static_cast<GainT>(1);
+
+    // Band edges [Hz]
+    static constexpr double lowcut(std::size_t band)
+    {
+        return BaseHz * static_cast<double>(uint64_t(1) << band) / detail::kSqrt2;
+    }
+    static constexpr double highcut(std::size_t band)
+    {
+        const double edge = BaseHz * static_cast<double>(uint64_t(1) << band) * detail::kSqrt2;
+        const double limit = 0.9 * 0.5 * FS;
+        return (edge < limit) ? edge : limit;
+    }
+
+    // Q31 bands centered below FS / 32 keep a 64-bit feedback state
+    static constexpr bool wide_state(std::size_t band)
+    {
+        return kFixedPoint && (BaseHz * static_cast<double>(uint64_t(1) << band) < FS / 32.0);
+    }
+
+private:
+    static constexpr bool edges_valid()
+    {
+        for (std::size_t band = 0; band < Bands; band++)
+        {
+            if (!(lowcut(band) > 0.0) || !(lowcut(band) < highcut(band)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(edges_valid(), "The top band does not fit below the Nyquist frequency");
+
+public:
+    // Bank designed at compile time, then quantized to Q31 or cast to SampleT
+    static constexpr std::array<detail::Sections<Stages>, Bands> kDesign = []
+    {
+        std::array<detail::Sections<Stages>, Bands> design{};
+        for (std::size_t band = 0; band < Bands; band++)
+        {
+            design[band] = detail::butter_bandpass<Stages>(lowcut(band), highcut(band), FS);
+        }
+        return design;
+    }();
+
+    static constexpr std::array<std::array<std::array<CoeffT, 5>, Stages>, Bands> kCoefficients = []
+    {
+        std::array<std::array<std::array<CoeffT, 5>, Stages>, Bands> coefficients{};
+        for (std::size_t band = 0; band < Bands; band++)
+        {
+            for (std::size_t stage = 0; stage < Stages; stage++)
+            {
+                for (std::size_t coeff = 0; coeff < 5; coeff++)
+                {
+                    const double value = kDesign[band][stage][coeff];
+                    coefficients[band][stage][coeff] =
+                        kFixedPoint ? static_cast<CoeffT>(detail::round(value * static_cast<double>(uint64_t(1) << (31 - PostShift))))
+                                    : static_cast<CoeffT>(value);
+                }
+            }
+        }
+        return coefficients;
+    }();
+
+    EqualizerBank()
+    {
+        reset();
+        gain_.fill(kGainUnity);
+    }
+
+    // Clears the filter states
+    void reset()
+    {
+        state_ = {};
+    }
+
+    // Sets the gain of one band in the mix (Q4.27 for Q31 samples)
+    void set_gain(std::size_t band, GainT gain)
+    {
+        gain_[band] = gain;
+    }
+
+    // Filters a block through all bands and writes the sum of the scaled bands
+    void process(const SampleT* __restrict pSrc, SampleT* __restrict pDst, std::size_t blockSize)
+    {
+        process(pSrc, pDst, blockSize, std::make_index_sequence<Bands>{});
+    }
+
+private:
+    using AccT = typename std::conditional<kFixedPoint, int64_t, SampleT>::type;
+
+    // x[n-1], x[n-2] and y[n-1], y[n-2] of a stage, y is Q63 on the 32x64 kernel
+    struct StageState
+    {
+        SampleT x1;
+        SampleT x2;
+        AccT    y1;
+        AccT    y2;
+    };
+    using BankState = std::array<std::array<StageState, Stages>, Bands>;
+
+    // One second-order section, with its coefficients as constants
+    template <std::size_t Band, std::size_t Stage>
+    static SampleT stage(SampleT x, StageState& s)
+    {
+        constexpr std::array<CoeffT, 5> c = kCoefficients[Band][Stage];
+
+        if constexpr (kFixedPoint && wide_state(Band))
+        {
+            // arm_biquad_cas_df1_32x64_q31
+            const int64_t acc = int64_t(x) * c[0] + int64_t(s.x1) * c[1] + int64_t(s.x2) * c[2] +
+                                mult32x64(s.y1, c[3]) + mult32x64(s.y2, c[4]);
+            s.x2 = s.x1;
+            s.x1 = x;
+            s.y2 = s.y1;
+            s.y1 = static_cast<int64_t>(static_cast<uint64_t>(acc) << (PostShift + 1));
+            return static_cast<int32_t>(s.y1 >> 32);
+        }
+        else if constexpr (kFixedPoint)
+        {
+            // arm_biquad_cascade_df1_q31
+            const int64_t acc = int64_t(x) * c[0] + int64_t(s.x1) * c[1] + int64_t(s.x2) * c[2] +
+                                s.y1 * c[3] + s.y2 * c[4];
+            const int32_t y = static_cast<int32_t>(acc >> (31 - PostShift));
+            s.x2 = s.x1;
+            s.x1 = x;
+            s.y2 = s.y1;
+            s.y1 = y;
+            return y;
+        }
+        else
+        {
+            const SampleT y = c[0] * x + c[1] * s.x1 + c[2] * s.x2 + c[3] * s.y1 + c[4] * s.y2;
+            s.x2 = s.x1;
+            s.x1 = x;
+            s.y2 = s.y1;
+            s.y1 = y;
+            return y;
+        }
+    }
+
+    // The stages of one band in turn, unrolled
+    template <std::size_t Band, std::size_t... Stage>
+    static SampleT band(SampleT x, std::array<StageState, Stages>& s, std::index_sequence<Stage...>)
+    {
+        ((x = stage<Band, Stage>(x, s[Stage])), ...);
+        return x;
+    }
+
+    template <std::size_t... Band>
+    void process(const SampleT* __restrict pSrc, SampleT* __restrict pDst, std::size_t blockSize,
+                 std::index_sequence<Band...>)
+    {
+        // Local copies so that the state stays in registers over the block
+        BankState state = state_;
+        const std::array<GainT, Bands> gain = gain_;
+
+        for (std::size_t sample = 0; sample < blockSize; sample++)
+        {
+            const SampleT x = pSrc[sample];
+
+            if constexpr (kFixedPoint)
+            {
+                // 64-bit sum saturated once at the end, as in ARM_Equalizer_mix()
+                int64_t sum = 0;
+                ((sum += (int64_t(band<Band>(x, state[Band], std::make_index_sequence<Stages>{})) * gain[Band]) >>
+                         kGainFractionBits), ...);
+                pDst[sample] = (sum > INT32_MAX) ? INT32_MAX : (sum < INT32_MIN) ? INT32_MIN : static_cast<int32_t>(sum);
+            }
+            else
+            {
+                SampleT sum = 0;
+                ((sum += band<Band>(x, state[Band], std::make_index_sequence<Stages>{}) * gain[Band]), ...);
+                pDst[sample] = sum;
+            }
+        }
+
+        state_ = state;
+    }
+
+    // 64 x 32-bit multiply of the CMSIS 32x64 kernel, keeps the upper 64 bits of the Q94 product
+    static int64_t mult32x64(int64_t x, int32_t y)
+    {
+        return ((static_cast<int64_t>(x & 0xFFFFFFFF) * y) >> 32) + (x >> 32) * y;
+    }
+
+    BankState              state_;
+    std::array<GainT, Bands> gain_;
+};
+
+} // namespace eq
+
+#endif // EQ_BANK_HPP
@@ -8,14 +8,31 @@ Description: This module provides filter coefficients for an audio
 
 # ~~~~~~~~~~ Python Libraries ~~~~~~~~~~~~~
 
-import cmsisdsp as dsp
+import hashlib
+import importlib
+import itertools
+import json
+import os
+import sys
 import numpy as np
-import librosa
-import soundfile as sf
-import matplotlib.pyplot as plt
-from pylab import figure, plot, show
-from scipy.signal import butter, sosfreqz, freqz, tf2zpk, zpk2sos, sosfilt
-from matplotlib.ticker import ScalarFormatter
+
+class LazyModule:
+
+    # Stands in for a module that is only imported on its first use, scipy.signal, 
+    # matplotlib, librosa and cmsisdsp take longer to import than the headless design 
+    # takes to run
+    def __init__(self, name):
+        self.name = name
+        
+    def __getattr__(self, attribute):
+        return getattr(importlib.import_module(self.name), attribute)
+        
+signal = LazyModule("scipy.signal")
+dsp = LazyModule("cmsisdsp")
+librosa = LazyModule("librosa")
+sf = LazyModule("soundfile")
+plt = LazyModule("matplotlib.pyplot")
+ticker = LazyModule("matplotlib.ticker")
 
 # ~~~~~~~~~~ Define Parameters ~~~~~~~~~~~~~
 
@@ -26,21 +43,284 @@ FS                  = 16000       # Hz sampling rate
 SIG_BASE_FREQUENCY  = 80          # Main frequency for the generated input signal
 SIG_NOISE_FREQUENCY = 2000        # Noise frequency for the generated input signal
 
-POSTSHIFT           = 4           # Scales the input signal by 4^2 before processesing
+POSTSHIFT           = 4           # postShift of the biquads, the coefficients are scaled down by 2^POSTSHIFT
 NUMSTAGES           = 3           # Number of cascaded biquad filters applied to each band / Butterworth bandpass SOS order
 
+LOW_BANDS           = 3           # Number of low bands that can run on the alternative kernels in Eq_ARM.c
+COMPARE_STRUCTURES  = False       # True to print the fixed-point cost/accuracy comparison of the biquad structures
+OPTIMIZE_QUANTIZATION = False     # True to search for the best quantized SOS of every band and kernel
+
+OPT_POSTSHIFTS      = range(1, 7) # PostShift values tried by the quantization optimizer
+OPT_INPUT_SCALE     = 1 / 8       # Input scaling of ARM_Equalizer (2^-3), used for the overflow check
+NOISE_TARGET_DB     = -101        # Noise a band may add [dBFS], this is the noise floor of the Q15 output
+
+GENERATE_RATE_TABLE = False       # True to write the bank of every rate in RATE_TABLE_RATES to RATE_TABLE_FILENAME
+RATE_TABLE_RATES    = [8000, 16000, 22050, 32000, 44100, 48000, 96000] # Hz, rates ARM_Equalizer_set_rate() can switch to
+RATE_TABLE_EDGE_LIMIT = 0.9       # Highest band edge relative to the Nyquist frequency, only limits the 8 kHz bank
+RATE_TABLE_FILENAME = "Eq_ARM_coeffs.h"
+
+GENERATE_GAIN_TABLE = False       # True to write the band gain table of the presets to GAIN_TABLE_FILENAME
+GAIN_TABLE_MIN_DB   = -24.0       # dB, lowest band gain of a preset
+GAIN_TABLE_MAX_DB   = 24.0        # dB, highest band gain, the Q4.27 mix gains end at +24.08 dB
+GAIN_TABLE_STEP_DB  = 0.5         # dB, grid of the preset band gains
+GAIN_FRACTION_BITS  = 27          # Fraction bits of the band gains in the mix of Eq_ARM.c
+SCALE_FACTOR        = 1           # Default gain of band 1 is 2^SCALE_FACTOR, like bandMixGain[0] in Eq_ARM.c
+GAIN_TABLE_FILENAME = "Eq_ARM_gains.h"
+
+SAMPLES_PER_TRANSFER = 256        # Block size of ARM_Equalizer, these have to match Eq_ARM.c for the bank model
+HEADROOM_BITS       = 3           # Bits the block floating point keeps free above the block peak
+BLOCK_EXPONENT_MAX  = 12          # Largest block exponent of quiet blocks
+
+FILTER_BLOCK_SIZE   = 1 << 16     # Samples the SciPy bank filters at a time, bounds its memory
+
 GENERATE_SIGNAL     = True        # False for wav input, True for generated signal
+STREAM_INPUT        = False       # True to stream the wav input block by block (long recordings, only the output spectra are plotted)
 LOG_SCALE_PLOT      = True        # True for a log plot of the filter freq resp, linear elsewise
 
 FIG_WIDTH           = 12          # Width in inches
 FIG_HEIGHT          = 6           # Height in inches
+SPECTRUM_SEGMENT    = 4096        # Samples per Welch segment of the spectra, sets their resolution
+SPECTRUM_RANGE_DB   = 60          # dB below the peak of the SciPy spectrum down to which the spectra are compared
+PLOT_POINTS         = 2000        # Columns of the time plots, longer signals are reduced to their min/max per column
+ 
+CHECK_MODEL         = False       # True (or --check-model) to check equalizer_q31 against eq_arm, or the scalar kernel models without it
+CHECK_MODEL_SAMPLES = 4096        # Samples of the model check
+ 
+HEADLESS            = False       # True (or --headless) to only design the bank and write BANK_JSON_FILENAME and BANK_HEADER_FILENAME
+BANK_JSON_FILENAME  = "Eq_ARM_bank.json"
+BANK_HEADER_FILENAME = "Eq_ARM_bank.h"
+
+DESIGN_CACHE        = True        # True to keep every designed bank in DESIGN_CACHE_DIR and load it from there on later runs
+DESIGN_CACHE_DIR    = ".eq_cache" # One .npz per bank, named by the hash of the design parameters
+DESIGN_CACHE_VERSION = 2          # Bump when the design or the cached data changes, old entries are then left unused
+RESPONSE_POINTS     = 512         # Frequencies of the cached magnitude responses, 0 to the Nyquist frequency
  
 INPUT_FILENAME      = "input_file.wav"
 SCIPY_OUT_FILENAME  = "SciPy-output_file.wav"
 ARM_OUT_FILENAME    = "ARM-output_file.wav"
+C_OUT_FILENAME      = "C-output_file.wav"   # Output of the C engine, written by the ARM path with eq_arm, compared when it exists
+
+# ~~~~~~~~~~ Fixed-Point Models ~~~~~~~~~~~~
+
+# Bit-exact scalar models of the Q31 biquad kernels available in Eq_ARM.c. Python
+# integers are used so that the 64-bit (and 96-bit for 32x64) accumulators are exact.
+# Each takes the Q31 coefficients of one stage and a list of Q31 input samples.
+
+def df1_q31(coefs, x, postshift):
+    # arm_biquad_cascade_df1_q31: 32x32 products, output truncated to 1.31
+    b0, b1, b2, a1, a2 = coefs
+    x1 = x2 = y1 = y2 = 0
+    y = []
+    for xn in x:
+        acc = b0 * xn + b1 * x1 + b2 * x2 + a1 * y1 + a2 * y2
+        x2, x1, y2, y1 = x1, xn, y1, acc >> (31 - postshift)
+        y.append(y1)
+    return y
+
+def df1_ef_q31(coefs, x, postshift):
+    # eq_biquad_cas_df1_ef_q31: as df1_q31 with the truncated bits fed back
+    b0, b1, b2, a1, a2 = coefs
+    shift = 31 - postshift
+    x1 = x2 = y1 = y2 = err = 0
+    y = []
+    for xn in x:
+        acc = err + b0 * xn + b1 * x1 + b2 * x2 + a1 * y1 + a2 * y2
+        err = acc & ((1 << shift) - 1)
+        x2, x1, y2, y1 = x1, xn, y1, acc >> shift
+        y.append(y1)
+    return y
+
+def df1_32x64_q31(coefs, x, postshift):
+    # arm_biquad_cas_df1_32x64_q31: outputs kept as 1.63 in the state
+    b0, b1, b2, a1, a2 = coefs
+    x1 = x2 = y1 = y2 = 0
+    y = []
+    for xn in x:
+        acc = b0 * xn + b1 * x1 + b2 * x2 + ((y1 * a1) >> 32) + ((y2 * a2) >> 32)
+        x2, x1, y2 = x1, xn, y1
+        y1 = ((acc << (postshift + 1)) + (1 << 63)) % (1 << 64) - (1 << 63)
+        y.append(y1 >> 32)
+    return y
+
+def coupled_q31(coefs, x, postshift):
+    # eq_biquad_cas_coupled_q31: coupled-form (Gold-Rader) section
+    d, g, cr, ci, c1, c2 = coefs
+    shift = 31 - postshift
+    v1 = v2 = 0
+    y = []
+    for xn in x:
+        y.append((d * xn + c1 * v1 + c2 * v2) >> shift)
+        v1, v2 = (cr * v1 - ci * v2 + g * xn) >> shift, (ci * v1 + cr * v2) >> shift
+    return y
+
+# Model, multiplies per sample and stage (a 32x64 product counts as two 32x32 ones) and
+# state words per stage of every kernel
+BIQUAD_KERNELS = {
+    "DF1 32x32":  (df1_q31,       5, "4 x 32-bit"),
+    "DF1 EF":     (df1_ef_q31,    5, "5 x 32-bit"),
+    "DF1 32x64":  (df1_32x64_q31, 9, "2 x 32-bit + 2 x 64-bit"),
+    "Coupled":    (coupled_q31,   8, "2 x 32-bit"),
+}
+
+def mult32x64(y, a):
+    # mult32x64 of CMSIS on int64 arrays: the upper 64 bits of the 96-bit product
+    return (((y & 0xFFFFFFFF) * a) >> 32) + (y >> 32) * a
+
+def equalizer_q31(x, coefs, postshift=POSTSHIFT, low_bands=LOW_BANDS, gains=None, block=SAMPLES_PER_TRANSFER):
+    # Bit-exact vectorized model of ARM_Equalizer in Eq_ARM.c (default configuration, 
+    # 32x64 kernel for the low bands): block floating point exponent and state rescale, 
+    # conversion to Q31, the DF1 cascades of all bands, the Q4.27 band gains and the 
+    # saturating 64-bit mix, and the truncating conversion back to int16.
+    #   x      - int16 input samples
+    #   coefs  - Q31 DF1 coefficients {b0, b1, b2, -a1, -a2}, shape (..., bands, stages, 5),
+    #            the leading axes are configurations that are all run at once
+    #   postshift - postShift of the cascades, a scalar or one per configuration
+    #   gains  - Q4.27 band gains, shape (..., bands), the defaults of ARM_Equalizer_init()
+    #            if None (band 1 at 2^SCALE_FACTOR, the others at unity)
+    # Returns the int16 output of every configuration, shape (..., samples).
+    # All bands and configurations are processed together with int64 arrays: the 
+    # feedforward half of every stage, the mix and the conversions are whole-block 
+    # operations, only the feedback recursion runs sample by sample.
+    x = np.asarray(x, dtype=np.int16)
+    coefs = np.asarray(coefs, dtype=np.int64)
+    configs = coefs.shape[:-3]
+    num_bands, num_stages = coefs.shape[-3:-1]
+    coefs = np.reshape(coefs, (-1, num_bands, num_stages, 5))
+    num_configs = len(coefs)
+    postshift = np.reshape(np.broadcast_to(np.asarray(postshift, dtype=np.int64), configs), (-1, 1))
+    
+    if gains is None:
+        gains = np.full((num_configs, num_bands), 1 << GAIN_FRACTION_BITS, dtype=np.int64)
+        gains[:, 0] <<= SCALE_FACTOR
+    else:
+        gains = np.reshape(np.broadcast_to(np.asarray(gains, dtype=np.int64), configs + (num_bands,)), (-1, num_bands))
+    
+    # Lanes of the two kernels: bands [0, low_bands) keep their outputs as 1.63 
+    # (arm_biquad_cas_df1_32x64_q31), the others as 1.31 (arm_biquad_cascade_df1_q31).
+    # The state is {x[n-1], x[n-2], y[n-1], y[n-2]} of every stage like in CMSIS.
+    kernels = [(slice(0, low_bands), True), (slice(low_bands, num_bands), False)]
+    state = np.zeros((num_configs, num_bands, num_stages, 4), dtype=np.int64)
+    block_exponent = np.full(num_configs, -HEADROOM_BITS, dtype=np.int64)
+    block_band_peak = np.zeros(num_configs, dtype=np.int64)
+    output = np.zeros((num_configs, len(x)), dtype=np.int16)
+    
+    def clz32(value):
+        # __CLZ of non-negative 32-bit values, 32 for 0
+        return 32 - np.frexp(value)[1].astype(np.int64)
+    
+    for start in range(0, len(x), block):
+        xb = x[start:start + block].astype(np.int64)
+        n = len(xb)
+        
+        # ARM_Equalizer_exponent: arm_absmax_q15 saturates |-32768| to 32767
+        input_peak = min(np.max(np.abs(xb)), 32767)
+        exponent = np.full(num_configs, clz32(input_peak << 16) - 1 - HEADROOM_BITS)
+        exponent = np.minimum(exponent, block_exponent + clz32(block_band_peak) - 1 - HEADROOM_BITS)
+        exponent = np.clip(np.minimum(exponent, block_exponent + 1), -HEADROOM_BITS, BLOCK_EXPONENT_MAX)
+        
+        # ARM_Equalizer_rescale: eq_shift_state_q63 for the low bands, eq_shift_state_q31 else
+        shift = (exponent - block_exponent)[:, None, None, None]
+        right = state >> np.maximum(-shift, 0)
+        left = state << np.maximum(shift, 0)
+        low = state[:, :low_bands]
+        left_low = left[:, :low_bands]
+        left[:, :low_bands] = np.where((left_low >> np.maximum(shift, 0)) == low, left_low,
+                                       np.where(low < 0, np.iinfo(np.int64).min, np.iinfo(np.int64).max))
+        left[:, low_bands:] = np.clip(left[:, low_bands:], -2**31, 2**31 - 1)
+        state = np.where(shift < 0, right, left)
+        block_exponent = exponent
+        
+        # Input conversion with the exponent, then the cascades. The 32x64 kernel keeps 
+        # x[n-1], x[n-2] in 64 bits and reads them back truncated to 32 bits.
+        stage_input = np.broadcast_to((xb[None, :] << (16 + exponent[:, None]))[:, None, :], (num_configs, num_bands, n))
+        for stage in range(num_stages):
+            b0, b1, b2, a1, a2 = np.moveaxis(coefs[:, :, stage, :], -1, 0)
+            x1 = ((state[:, :, stage, 0] + 2**31) & 0xFFFFFFFF) - 2**31
+            x2 = ((state[:, :, stage, 1] + 2**31) & 0xFFFFFFFF) - 2**31
+            padded = np.concatenate((x2[:, :, None], x1[:, :, None], stage_input), axis=2)
+            feedforward = b0[:, :, None] * stage_input + b1[:, :, None] * padded[:, :, 1:-1] + b2[:, :, None] * padded[:, :, :-2]
+            feedforward = np.ascontiguousarray(np.moveaxis(feedforward, 2, 0))
+            stage_output = np.empty((n, num_configs, num_bands), dtype=np.int64)
+            
+            for lanes, wide in kernels:
+                ff = feedforward[:, :, lanes]
+                c1, c2 = a1[:, lanes], a2[:, lanes]
+                y1, y2 = state[:, lanes, stage, 2].copy(), state[:, lanes, stage, 3].copy()
+                out = stage_output[:, :, lanes]
+                if wide:
+                    for i in range(n):
+                        y1, y2 = (ff[i] + mult32x64(y1, c1) + mult32x64(y2, c2)) << (postshift + 1), y1
+                        out[i] = y1 >> 32
+                else:
+                    for i in range(n):
+                        y1, y2 = (ff[i] + c1 * y1 + c2 * y2) >> (31 - postshift), y1
+                        out[i] = y1
+                state[:, lanes, stage, 2] = y1
+                state[:, lanes, stage, 3] = y2
+                
+            state[:, :, stage, 0] = padded[:, :, -1]
+            state[:, :, stage, 1] = padded[:, :, -2]
+            stage_input = np.moveaxis(stage_output, 0, 2)
+        
+        # ARM_Equalizer_mix, then arm_q31_to_q15
+        mix = np.sum((stage_input * gains[:, :, None]) >> GAIN_FRACTION_BITS, axis=1)
+        mix = np.where(exponent[:, None] >= 0, mix >> np.maximum(exponent, 0)[:, None], mix << np.maximum(-exponent, 0)[:, None])
+        output[:, start:start + n] = np.clip(mix, -2**31, 2**31 - 1) >> 16
+        block_band_peak = np.bitwise_or.reduce(np.reshape(stage_input ^ (stage_input >> 31), (num_configs, -1)), axis=1)
+    
+    return np.reshape(output, configs + (len(x),))
+
+# Kernels the quantization optimizer can target, from the cheapest to the most expensive.
+# Each has its coefficient/sample word length and how the truncation noise of a stage is 
+# shaped: 'state' is fed back through the poles, 'ef' also gets the zero at DC of the error 
+# feedback and 'output' only reaches the following stages (64-bit state).
+OPT_KERNELS = {
+    "DF1 Q15":   (16, "state"),
+    "DF1 32x32": (32, "state"),
+    "DF1 EF":    (32, "ef"),
+    "DF1 32x64": (32, "output"),
+}
 
 # ~~~~~~~~~~ Class Definitions ~~~~~~~~~~~~~
 
+class WelchSpectrum:
+
+    # Averaged periodogram (Welch, periodic Hann window, 50 % overlap) that is fed block 
+    # by block as the signal is filtered, so the spectrum of any length costs one block 
+    # and one segment of memory. The samples of the unfinished segment at the end of a 
+    # block are kept for the next one.
+    def __init__(self, fs, segment=SPECTRUM_SEGMENT):
+        self.fs = fs
+        self.segment = segment
+        self.window = np.hanning(segment + 1)[:-1]
+        self.tail = np.zeros(0)
+        self.power = np.zeros(segment // 2 + 1)
+        self.count = 0
+        
+    def update(self, block):
+        samples = np.concatenate((self.tail, block))
+        hop = self.segment // 2
+        count = max(0, (len(samples) - self.segment) // hop + 1)
+        
+        if count > 0:
+            segments = np.lib.stride_tricks.sliding_window_view(samples, self.segment)[::hop][:count]
+            self.power += np.sum(np.abs(np.fft.rfft(segments * self.window, axis=1))**2, axis=0)
+            self.count += count
+            
+        self.tail = samples[count * hop:]
+        
+    def density(self):
+    
+        # One-sided power spectral density like scipy.signal.welch(detrend=False), signals 
+        # shorter than a segment give one zero padded segment
+        if self.count == 0:
+            self.update(np.zeros(self.segment - len(self.tail)))
+            
+        psd = self.power / (self.count * self.fs * np.sum(self.window**2))
+        psd[1:-1] *= 2
+        
+        return np.fft.rfftfreq(self.segment, 1 / self.fs), psd
+        
 class SignalProcessor:
     def __init__(self):
         self.fs = FS
@@ -48,9 +328,14 @@ class SignalProcessor:
         self.num_bands = NUM_BANDS + 1
         self.input_signal = None
         self.sos_list = []
+        self.q31_list = []
+        self.coupled_list = []
+        self.responses = None
+        self.spectra = {}
         self.frequencies = []
         self.edges = []
         self.coefs = []
+        self.engine = None
         
         return
         
@@ -68,17 +353,17 @@ class SignalProcessor:
         plt.figure(figsize=(FIG_WIDTH, FIG_HEIGHT))
         
         plt.subplot(2, 1, 1) 
-        plt.plot(t, self.input_signal, label='Generated Noise Signal')
+        self.plot_min_max(self.input_signal, self.fs, label='Generated Noise Signal')
         plt.title('Original Signal: Time Domain')
         plt.xlabel('Time (s)')
         plt.ylabel('Amplitude')
         plt.legend()
         
         plt.subplot(2, 1, 2)
-        plt.magnitude_spectrum(self.input_signal, Fs=self.fs, scale='dB')
+        self.plot_spectrum(self.signal_spectrum(self.input_signal, self.fs))
         plt.title('Original Signal: Frequency Domain')
         plt.xlabel('Frequency (Hz)')
-        plt.ylabel('Magnitude (dB)')
+        plt.ylabel('Power (dB/Hz)')
         
         plt.tight_layout()
         
@@ -95,23 +380,106 @@ class SignalProcessor:
         plt.figure(figsize=(FIG_WIDTH, FIG_HEIGHT))
         
         plt.subplot(2, 1, 1)
-        plt.plot(np.arange(len(self.input_signal)) / fs, self.input_signal, label='Your Input Signal')
+        self.plot_min_max(self.input_signal, fs, label='Your Input Signal')
         plt.title('Input Signal: Time Domain')
         plt.xlabel('Time (s)')
         plt.ylabel('Amplitude')
         plt.legend()
         
         plt.subplot(2, 1, 2)
-        plt.magnitude_spectrum(self.input_signal, Fs=fs, scale='dB')
+        self.plot_spectrum(self.signal_spectrum(self.input_signal, fs))
         plt.title('Input Signal: Frequency Domain')
         plt.xlabel('Frequency (Hz)')
-        plt.ylabel('Magnitude (dB)')
+        plt.ylabel('Power (dB/Hz)')
         
         plt.tight_layout()
         
         return
         
-    def calculate_centers(self, base_frequency, num_bands):
+    def plot_min_max(self, samples, fs, label):
+    
+        # Plot a time signal reduced to the minimum and maximum of each of PLOT_POINTS 
+        # columns, found in one vectorized pass with reduceat. Drawn as a vertical line per 
+        # column it looks the same as every sample at screen resolution, but the plot stays 
+        # at 2 * PLOT_POINTS points for any length.
+        samples = np.asarray(samples)
+        if len(samples) <= 2 * PLOT_POINTS:
+            plt.plot(np.arange(len(samples)) / fs, samples, label=label)
+            return
+            
+        starts = np.linspace(0, len(samples), PLOT_POINTS, endpoint=False).astype(np.int64)
+        lows = np.minimum.reduceat(samples, starts)
+        highs = np.maximum.reduceat(samples, starts)
+        
+        plt.plot(np.repeat(starts / fs, 2), np.column_stack((lows, highs)).ravel(), label=label)
+        
+        return
+        
+    def signal_spectrum(self, samples, fs):
+    
+        # Welch spectrum of a signal in memory, fed FILTER_BLOCK_SIZE samples at a time
+        spectrum = WelchSpectrum(fs)
+        for start in range(0, len(samples), FILTER_BLOCK_SIZE):
+            spectrum.update(samples[start:start + FILTER_BLOCK_SIZE])
+            
+        return spectrum
+        
+    def file_spectrum(self, filename, block_size=FILTER_BLOCK_SIZE):
+    
+        # Welch spectrum of a wav file, read block by block and mixed down to mono
+        spectrum = None
+        for block in sf.blocks(filename, blocksize=block_size, dtype="float32", always_2d=True):
+            if spectrum is None:
+                spectrum = WelchSpectrum(sf.info(filename).samplerate)
+            spectrum.update(np.mean(block, axis=1))
+            
+        return spectrum
+        
+    def plot_spectrum(self, spectrum, label=None):
+    
+        # Plot a Welch spectrum in dB
+        freq, psd = spectrum.density()
+        plt.plot(freq, 10 * np.log10(np.maximum(psd, 1e-30)), label=label)
+        
+        return
+        
+    def compare_spectra(self):
+    
+        # Plot the spectra of the outputs collected while filtering (and of C_OUT_FILENAME 
+        # if it exists and eq_arm did not run) on top of each other and print how far each 
+        # one is from SciPy, over the bins down to SPECTRUM_RANGE_DB below the peak
+        spectra = dict(self.spectra)
+        if "C" not in spectra and os.path.exists(C_OUT_FILENAME):
+            spectra["C"] = self.file_spectrum(C_OUT_FILENAME)
+        if "SciPy" not in spectra:
+            return
+            
+        _, reference = spectra["SciPy"].density()
+        reference_db = 10 * np.log10(np.maximum(reference, 1e-30))
+        compared = reference_db > np.max(reference_db) - SPECTRUM_RANGE_DB
+        
+        print(f"~~~~~~~~~~ Output spectra against SciPy (largest difference within {SPECTRUM_RANGE_DB} dB of the peak) ~~~~~~~~~~ \n")
+        plt.figure(figsize=(FIG_WIDTH, FIG_HEIGHT))
+        
+        for name, spectrum in spectra.items():
+            self.plot_spectrum(spectrum, label=f"{name} Filtered Signal")
+            if name != "SciPy":
+                freq, psd = spectrum.density()
+                if len(psd) != len(reference):
+                    print(f"{name}:\tdifferent sample rate, not compared")
+                    continue
+                difference = np.abs(10 * np.log10(np.maximum(psd, 1e-30)) - reference_db)[compared]
+                print(f"{name}:\t{np.max(difference):.2f} dB")
+                
+        print("")
+        plt.title('Welch Spectra of the Filtered Signals')
+        plt.xlabel('Frequency (Hz)')
+        plt.ylabel('Power (dB/Hz)')
+        plt.legend()
+        
+        return
+        
+    def calculate_centers(self, base_frequency, num_bands, verbose=True):
     
         # Calculate the frequencies and frequency edges based upon the octave frequency and number of bands desired
         frequencies = [base_frequency * 2**i for i in range(-1, num_bands)]
@@ -121,41 +489,122 @@ class SignalProcessor:
             edges[i] = 10**(np.log10(frequencies[i]) + ((np.log10(frequencies[i+1]) - np.log10(frequencies[i])) / 2))
     
         # Print out the obtained frequency bands
-        print(f"\nOctaves [Hz]\t\tEdge Frequencies [Hz]\n")
-        for i, (freq, edge) in enumerate(zip(frequencies, edges)):
-            if i == 0:
-                print(f"Omitted band\n{freq:8.2f} [Hz]\t\t0\tand {edge:8.2f} [Hz]\n")
-                print(f"Bands used:")
-            else:
-                print(f"{freq:8.2f} [Hz]\t\t{edges[i-1]:.2f}\tand {edge:8.2f} [Hz]")
-        print(f"\n")
+        if verbose:
+            print(f"\nOctaves [Hz]\t\tEdge Frequencies [Hz]\n")
+            for i, (freq, edge) in enumerate(zip(frequencies, edges)):
+                if i == 0:
+                    print(f"Omitted band\n{freq:8.2f} [Hz]\t\t0\tand {edge:8.2f} [Hz]\n")
+                    print(f"Bands used:")
+                else:
+                    print(f"{freq:8.2f} [Hz]\t\t{edges[i-1]:.2f}\tand {edge:8.2f} [Hz]")
+            print(f"\n")
         
         self.frequencies = frequencies
         self.edges = edges  
         
         return frequencies, edges
         
+    def design_bank(self):
+    
+        # Design the Butterworth bandpass of every band at the sample rate of the bank 
+        # without plotting anything
+        bank = self.load_bank(self.fs)
+        
+        self.sos_list = list(bank["sos"])
+        self.q31_list = list(bank["q31"])
+        self.coupled_list = list(bank["coupled"])
+        self.responses = (bank["freq"], bank["resp"])
+            
+        return self.sos_list
+        
+    def band_edges(self, fs, edge_limit=1.0):
+    
+        # Lower and upper edge of every band at fs, the highest ones limited to edge_limit 
+        # times the Nyquist frequency
+        bands = []
+        
+        for i in range(0, NUM_BANDS):
+            lowcut = self.edges[i]
+            highcut = min(self.edges[i + 1], edge_limit * fs / 2)
+            if lowcut >= highcut:
+                raise ValueError(f"Band {i + 1} does not fit below the Nyquist frequency of {fs} Hz")
+            bands.append((lowcut, highcut))
+            
+        return bands
+        
+    def load_bank(self, fs, edge_limit=1.0):
+    
+        # Designed SOS, Q31 DF1 and coupled-form coefficients (of the low bands) and the 
+        # magnitude responses of the bank at fs. Every 
+        # bank is kept in DESIGN_CACHE_DIR under the hash of what its design depends on, so 
+        # repeated runs and sweeps only design the parameter sets they have not seen yet. 
+        # The entries are written under a temporary name and renamed, which keeps parallel 
+        # runs from reading half-written files.
+        parameters = {
+            "version": DESIGN_CACHE_VERSION,
+            "edges": [float(edge) for edge in self.edges[:NUM_BANDS + 1]],
+            "fs": fs,
+            "edge_limit": edge_limit,
+            "num_stages": NUMSTAGES,
+            "postshift": POSTSHIFT,
+            "low_bands": LOW_BANDS,
+            "response_points": RESPONSE_POINTS,
+        }
+        digest = hashlib.sha256(json.dumps(parameters, sort_keys=True).encode()).hexdigest()
+        filename = os.path.join(DESIGN_CACHE_DIR, digest[:32] + ".npz")
+        
+        if DESIGN_CACHE and os.path.exists(filename):
+            with np.load(filename) as bank:
+                return dict(bank)
+                
+        sos = np.array([self.butter_bandpass_sos(lowcut, highcut, fs, order=NUMSTAGES)
+                        for lowcut, highcut in self.band_edges(fs, edge_limit)])
+        q31 = np.array([self.sos_to_q31(band) for band in sos])
+        coupled = np.array([np.round(self.sos_to_coupled(band) / (2 ** POSTSHIFT) * (2**31)) for band in sos[:LOW_BANDS]])
+        
+        # Responses like sosfreqz(sos, worN=RESPONSE_POINTS), evaluated on the sections
+        freq = np.arange(RESPONSE_POINTS) * fs / (2 * RESPONSE_POINTS)
+        delay = np.exp(-2j * np.pi * freq / fs)[:, np.newaxis]
+        resp = np.array([np.prod(np.polyval(band[:, 2::-1].T, delay) / np.polyval(band[:, :2:-1].T, delay), axis=1)
+                         for band in sos])
+        
+        bank = {"sos": sos, "q31": q31, "coupled": coupled, "freq": freq, "resp": resp}
+        
+        if DESIGN_CACHE:
+            os.makedirs(DESIGN_CACHE_DIR, exist_ok=True)
+            temporary = f"{filename}.{os.getpid()}.tmp"
+            with open(temporary, "wb") as file:
+                np.savez(file, **bank)
+            os.replace(temporary, filename)
+            
+        return bank
+        
     def plot_bandpass_filter_response(self, scale='linear'):
         plt.figure(figsize=(FIG_WIDTH, FIG_HEIGHT))
       
         # Obtain the freq, resp, and sos from the Butterworth bandpass filter
-        for i in range(0, NUM_BANDS):
+        self.design_bank()
+        
+        freq, responses = self.responses
+        
+        for i, (sos, resp) in enumerate(zip(self.sos_list, responses)):
             lowcut = self.edges[i]
             highcut = self.edges[i + 1]
-
-            freq, resp, sos = self.butter_bandpass(lowcut, highcut, self.fs, i, order=NUMSTAGES)
-            self.sos_list.append(sos)
             
-            # Scale the coefficients by the poststage factor and format to Q31
-            coefs=np.reshape(np.hstack((sos[:,:3],-sos[:,4:])), 15)
-            coefs = coefs / (POSTSHIFT ** 2)
-            coefsQ31 = (coefs * (2**31)) 
-            coefsQ31= np.round(coefsQ31)
+            # Coefficients scaled by the poststage factor and formatted to Q31
+            coefsQ31 = self.q31_list[i]
             
             print("")
             print("~~~~~~~~~~ Scaled Q31 Biquad Coefficient bands: {:.1f} Hz to {:.1f} Hz: ~~~~~~~~~~ \n".format(lowcut, highcut))
             print(" ".join("{:.2f}".format(x) for x in coefsQ31))
             print("\n\n")
+            
+            # The low bands can also run on the coupled-form kernel, which needs its own coefficients
+            if i < LOW_BANDS:
+                coupledQ31 = self.coupled_list[i]
+                print("~~~~~~~~~~ Scaled Q31 Coupled-Form Coefficients bands: {:.1f} Hz to {:.1f} Hz: ~~~~~~~~~~ \n".format(lowcut, highcut))
+                print(" ".join("{:.2f}".format(x) for x in np.reshape(coupledQ31, -1)))
+                print("\n\n")
              
             plt.plot(freq, np.abs(resp))
             plt.title('Magnitude Response of Butterworth Bandpass Filter')
@@ -167,45 +616,635 @@ class SignalProcessor:
             plt.semilogx(self.frequencies, np.ones_like(self.frequencies), 'o', label='Centres of the bandpass filters')
             plt.semilogx(self.edges, np.ones_like(self.edges) * 1, '*', label='Edges of the bandpass filters')
             plt.title('Logarithmic Scale Plot of Frequencies')
-            plt.gca().xaxis.set_major_formatter(ScalarFormatter())
+            plt.gca().xaxis.set_major_formatter(ticker.ScalarFormatter())
             plt.legend()
             plt.grid(True)
    
         return
             
-    def butter_bandpass(self, lowcut, highcut, fs, i, order): 
+    def butter_bandpass_sos(self, lowcut, highcut, fs, order):
     
-        # Calculate nyquist freq and the upper bounds of the bandpass filter
-        nyquist = 0.5 * fs
-        low = lowcut / nyquist
-        high = highcut / nyquist
+        # Design the bandpass straight from its poles like scipy.signal.butter(output='sos') 
+        # and eq_butter_bandpass_q31() in Eq_ARM.c: buttap, lp2bp_zpk at the prewarped edges 
+        # (SciPy designs at fs = 2), bilinear_zpk and the 'nearest' pairing of zpk2sos. There 
+        # is no round trip through the transfer function, whose roots came back with noise 
+        # on the zeros, and nothing but numpy is needed
+        warped = 4 * np.tan(np.pi * np.array([lowcut, highcut]) / fs)
+        bandwidth = warped[1] - warped[0]
+        center = np.sqrt(warped[0] * warped[1])
+        
+        # Poles of the analog lowpass prototype and their lowpass to bandpass pairs
+        lowpass = -np.exp(1j * np.pi * np.arange(-order + 1, order, 2) / (2 * order)) * bandwidth / 2
+        offset = np.sqrt(lowpass**2 - center**2)
+        analog = np.concatenate((lowpass + offset, lowpass - offset))
+        
+        # Bilinear transform, the order zeros at s = 0 end up at z = 1 and the others at z = -1
+        poles = list(((4 + analog) / (4 - analog))[analog.imag > 0])
+        gain = bandwidth**order * np.real(4.0**order / np.prod(4 - analog))
+        zeros = {1: order, -1: order}
+        sos = np.zeros((order, 6))
         
-        # Obtain the a & b coefficients for each filter 
-        # 5 coefficients for each filter * number of stages/order
-        b, a = butter(order, [low, high], btype='band', analog=False)
+        # Pair the poles, the one closest to the unit circle into the last section, with 
+        # the nearest zeros
+        for section in reversed(range(order)):
+            pole = poles.pop(int(np.argmin(np.abs(1 - np.abs(poles)))))
+            pair = []
+            for _ in range(2):
+                zero = 1 if zeros[-1] == 0 or (zeros[1] > 0 and abs(pole - 1) < abs(pole + 1)) else -1
+                zeros[zero] -= 1
+                pair.append(zero)
+            sos[section] = [1, -(pair[0] + pair[1]), pair[0] * pair[1], 1, -2 * pole.real, pole.real**2 + pole.imag**2]
+            
+        sos[0, :3] *= gain
+        
+        return sos
         
-        # Computes the frequency response of a digital filter
-        frequencies, response = freqz(b, a, fs=fs)
+    def sos_to_q31(self, sos):
+    
+        # CMSIS DF1 layout {b0, b1, b2, -a1, -a2} per stage, scaled down by the postShift 
+        # of the kernel (the coefficients can reach 2) and rounded to Q31
+        coefs = np.reshape(np.hstack((sos[:,:3],-sos[:,4:])), 5 * len(sos))
+        coefs = coefs / (2 ** POSTSHIFT)
+        coefsQ31 = np.round(coefs * (2**31))
         
-        # Obtain the zero, pole, and gain representation of a digital filter
-        z, p, k = tf2zpk(b, a)
+        return coefsQ31
         
-        # Return the second-order sections from zeros, poles, and gain of a system
-        sos = zpk2sos(z, p, k)
-     
-        return frequencies, response, sos   
+    def generate_rate_table(self, rates=RATE_TABLE_RATES, filename=RATE_TABLE_FILENAME):
+    
+        # Design the bank for every sample rate and write all of them into one packed table, 
+        # rate after rate, so that Eq_ARM.c (EQ_MULTI_RATE) can switch the rate by pointing 
+        # the filter instances at another entry. The band edges stay the same, only the 
+        # highest ones are limited below the Nyquist frequency of the low rates.
+        df1_rows = []
+        coupled_rows = []
+        
+        for fs in rates:
+            df1_rows.append(f"    // {fs} Hz")
+            coupled_rows.append(f"    // {fs} Hz")
+            
+            bank = self.load_bank(fs, RATE_TABLE_EDGE_LIMIT)
+            
+            for i, (lowcut, highcut) in enumerate(self.band_edges(fs, RATE_TABLE_EDGE_LIMIT)):
+                coupledQ31 = bank["coupled"][i] if i < LOW_BANDS else None
+                self.append_band_rows(df1_rows, coupled_rows, bank["q31"][i], coupledQ31, lowcut, highcut, fs, i)
+                        
+            df1_rows.append("")
+            coupled_rows.append("")
+            
+        header = [
+            "/**",
+            " *******************************************************************************",
+            f" * @file:    {os.path.basename(filename)}",
+            " * @brief:   Q31 coefficients of the equalizer bank for every sample rate that",
+            " *           ARM_Equalizer_set_rate() in Eq_ARM.c can switch to (EQ_MULTI_RATE).",
+            " *           Generated by Eq_SciPy_ARM.py (GENERATE_RATE_TABLE), do not edit.",
+            " *******************************************************************************",
+            " */",
+            "",
+            "#ifndef EQ_ARM_COEFFS_H",
+            "#define EQ_ARM_COEFFS_H",
+            "",
+            "// Layout of the tables, checked against the defines of Eq_ARM.c",
+            f"#define EQ_RATE_COUNT           {len(rates)}",
+            f"#define EQ_RATE_STAGES          {NUMSTAGES}",
+            f"#define EQ_RATE_BANDS           {NUM_BANDS}",
+            f"#define EQ_RATE_COUPLED_BANDS   {LOW_BANDS}",
+            f"#define EQ_RATE_POSTSHIFT       {POSTSHIFT}",
+            "",
+            "// Sample rate of every entry of the tables [Hz]",
+            "const uint32_t EQ_RATE_HZ[EQ_RATE_COUNT] =",
+            "{",
+            "    " + ", ".join(str(fs) for fs in rates),
+            "};",
+            "",
+            "// Rates * 3 stages * 6 bands * 5 coefficients for each biquad",
+            "const q31_t EQ_RATE_BIQUAD_COEFF[EQ_RATE_COUNT * EQ_RATE_STAGES * EQ_RATE_BANDS * 5] =",
+            "{",
+            *df1_rows[:-1],
+            "};",
+            "",
+            "// Rates * 3 stages * 3 low bands * 6 coefficients for each coupled-form section",
+            "const q31_t EQ_RATE_BIQUAD_COEFF_COUPLED[EQ_RATE_COUNT * EQ_RATE_STAGES * EQ_RATE_COUPLED_BANDS * 6] =",
+            "{",
+            *coupled_rows[:-1],
+            "};",
+            "",
+            "#endif // EQ_ARM_COEFFS_H",
+            "",
+        ]
+        
+        with open(filename, "w") as file:
+            file.write("\n".join(header))
+            
+        print(f"Wrote the bank for {len(rates)} sample rates to {filename}\n")
+        
+        return
+        
+    def append_band_rows(self, df1_rows, coupled_rows, coefsQ31, coupledQ31, lowcut, highcut, fs, i):
+    
+        # Format the Q31 coefficients of one band as C table rows, DF1 for every band and
+        # the coupled form for the low bands, as the generated headers lay them out
+        # The poles of the quantized sections have to stay inside the unit circle
+        for a1, a2 in np.reshape(coefsQ31, (-1, 5))[:, 3:] * (2 ** POSTSHIFT) / (2**31):
+            if np.max(np.abs(np.roots([1, -a1, -a2]))) >= 1:
+                print(f"Warning: band {i + 1} at {fs} Hz is unstable after quantization")
+        
+        comment = f"    // Bandpass #{i + 1}: {lowcut:.1f} Hz to {highcut:.1f} Hz"
+        df1_rows.append(comment)
+        for stage in np.reshape(coefsQ31, (-1, 5)).astype(np.int64):
+            df1_rows.append("    " + ", ".join(str(x) for x in stage) + ",")
+        
+        if coupledQ31 is not None:
+            coupled_rows.append(comment)
+            for stage in coupledQ31.astype(np.int64):
+                coupled_rows.append("    " + ", ".join(str(x) for x in stage) + ",")
+                
+        return
+        
+    def export_bank(self, json_filename=BANK_JSON_FILENAME, header_filename=BANK_HEADER_FILENAME):
+    
+        # Write the designed bank in machine-readable form: a JSON description for other 
+        # tools and the BIQUAD_COEFF tables Eq_ARM.c includes, so that nothing has to be 
+        # copied from the terminal output anymore
+        df1_rows = []
+        coupled_rows = []
+        bands = []
+        
+        for i, sos in enumerate(self.sos_list):
+            lowcut = self.edges[i]
+            highcut = self.edges[i + 1]
+            coupledQ31 = self.coupled_list[i] if i < LOW_BANDS else None
+            self.append_band_rows(df1_rows, coupled_rows, self.q31_list[i], coupledQ31, lowcut, highcut, self.fs, i)
+            df1_rows.append("")
+            if i < LOW_BANDS:
+                coupled_rows.append("")
+            
+            band = {
+                "lowcut": lowcut,
+                "highcut": highcut,
+                "sos": sos.tolist(),
+                "q31": self.q31_list[i].astype(np.int64).tolist(),
+            }
+            if i < LOW_BANDS:
+                band["coupled_q31"] = np.reshape(coupledQ31, -1).astype(np.int64).tolist()
+            bands.append(band)
+            
+        bank = {
+            "fs": self.fs,
+            "base_frequency": self.base_frequency,
+            "num_bands": NUM_BANDS,
+            "num_stages": NUMSTAGES,
+            "postshift": POSTSHIFT,
+            "low_bands": LOW_BANDS,
+            "bands": bands,
+        }
+        
+        with open(json_filename, "w") as file:
+            json.dump(bank, file, indent=2)
+            
+        header = [
+            "/**",
+            " *******************************************************************************",
+            f" * @file:    {os.path.basename(header_filename)}",
+            " * @brief:   Q31 coefficients of the equalizer bank of Eq_ARM.c at SAMPLE_RATE_HZ.",
+            " *           Generated by Eq_SciPy_ARM.py (HEADLESS or --headless), do not edit.",
+            " *******************************************************************************",
+            " */",
+            "",
+            "#ifndef EQ_ARM_BANK_H",
+            "#define EQ_ARM_BANK_H",
+            "",
+            "// Layout of the tables, checked against the defines of Eq_ARM.c",
+            f"#define EQ_BANK_SAMPLE_RATE_HZ  {self.fs}",
+            f"#define EQ_BANK_STAGES          {NUMSTAGES}",
+            f"#define EQ_BANK_BANDS           {NUM_BANDS}",
+            f"#define EQ_BANK_COUPLED_BANDS   {LOW_BANDS}",
+            f"#define EQ_BANK_POSTSHIFT       {POSTSHIFT}",
+            "",
+            "// 3 stages * 6 bands * 5 coefficients for each biquad",
+            "const q31_t BIQUAD_COEFF[EQ_BANK_STAGES * EQ_BANK_BANDS * 5] =",
+            "{",
+            *df1_rows[:-1],
+            "};",
+            "",
+            "// 3 stages * 3 low bands * 6 coefficients for each coupled-form section, only",
+            "// used when LOW_BAND_KERNEL is LOW_BAND_KERNEL_COUPLED",
+            "const q31_t BIQUAD_COEFF_COUPLED[EQ_BANK_STAGES * EQ_BANK_COUPLED_BANDS * 6] =",
+            "{",
+            *coupled_rows[:-1],
+            "};",
+            "",
+            "#endif // EQ_ARM_BANK_H",
+            "",
+        ]
+        
+        with open(header_filename, "w") as file:
+            file.write("\n".join(header))
+            
+        print(f"Wrote the bank to {json_filename} and {header_filename}")
+        
+        return
+        
+    def generate_gain_table(self, filename=GAIN_TABLE_FILENAME):
+    
+        # The band gains of the mix in Eq_ARM.c for every step of the dB grid, so that 
+        # ARM_Equalizer_apply_preset() (EQ_PRESETS) only looks them up instead of 
+        # calling powf() on the control path. Step 0 is 0 dB, steps are signed.
+        min_step = int(round(GAIN_TABLE_MIN_DB / GAIN_TABLE_STEP_DB))
+        max_step = int(round(GAIN_TABLE_MAX_DB / GAIN_TABLE_STEP_DB))
+        steps = np.arange(min_step, max_step + 1)
+        gains = np.round(10 ** (steps * GAIN_TABLE_STEP_DB / 20) * (2**GAIN_FRACTION_BITS)).astype(np.int64)
+        
+        if gains.max() > 2**31 - 1:
+            raise ValueError(f"{GAIN_TABLE_MAX_DB} dB does not fit the Q{31 - GAIN_FRACTION_BITS}.{GAIN_FRACTION_BITS} band gains")
+        
+        rows = []
+        for start in range(0, len(gains), 8):
+            rows.append(f"    // {steps[start] * GAIN_TABLE_STEP_DB:+.1f} dB")
+            rows.append("    " + ", ".join(str(x) for x in gains[start:start + 8]) + ",")
+            
+        header = [
+            "/**",
+            " *******************************************************************************",
+            f" * @file:    {os.path.basename(filename)}",
+            f" * @brief:   Q{31 - GAIN_FRACTION_BITS}.{GAIN_FRACTION_BITS} band gains of the mix in Eq_ARM.c for every {GAIN_TABLE_STEP_DB} dB step",
+            f" *           from {GAIN_TABLE_MIN_DB:+.1f} dB to {GAIN_TABLE_MAX_DB:+.1f} dB, used by ARM_Equalizer_apply_preset() (EQ_PRESETS).",
+            " *           Generated by Eq_SciPy_ARM.py (GENERATE_GAIN_TABLE), do not edit.",
+            " *******************************************************************************",
+            " */",
+            "",
+            "#ifndef EQ_ARM_GAINS_H",
+            "#define EQ_ARM_GAINS_H",
+            "",
+            "// Layout of the table, entry 0 is the gain of EQ_GAIN_MIN_STEP",
+            f"#define EQ_GAIN_STEPS_PER_DB    {int(round(1 / GAIN_TABLE_STEP_DB))}",
+            f"#define EQ_GAIN_MIN_STEP        ({min_step})",
+            f"#define EQ_GAIN_MAX_STEP        {max_step}",
+            f"#define EQ_GAIN_STEP_COUNT      {len(steps)}",
+            f"#define EQ_GAIN_FRACTION_BITS   {GAIN_FRACTION_BITS}",
+            "",
+            "// Band gain of every step",
+            "const q31_t EQ_GAIN_TABLE[EQ_GAIN_STEP_COUNT] =",
+            "{",
+            *rows,
+            "};",
+            "",
+            "#endif // EQ_ARM_GAINS_H",
+            "",
+        ]
+        
+        with open(filename, "w") as file:
+            file.write("\n".join(header))
+            
+        print(f"Wrote the gains of {len(steps)} steps to {filename}\n")
+        
+        return
+        
+    def sos_to_coupled(self, sos):
+    
+        # Convert every second-order section to the coupled (normal) form used by the 
+        # eq_biquad_cas_coupled_q31 kernel in Eq_ARM.c. Per stage the coefficients are
+        # {d, g, cr, ci, c1, c2}:
+        #   y[n]    = d * x[n] + c1 * v1[n] + c2 * v2[n]
+        #   v1[n+1] = cr * v1[n] - ci * v2[n] + g * x[n]
+        #   v2[n+1] = ci * v1[n] + cr * v2[n]
+        # where cr + j*ci is the pole of the section. Unlike the DF1 a1 = -2*r*cos(theta) and 
+        # a2 = r^2, the pole is stored directly, so the quantization grid of the poles is 
+        # uniform and does not get coarse near z = 1.
+        coupled = np.zeros((len(sos), 6))
+        length = 1 << 15
+        cascade = np.ones(length + 1)
+        
+        for i, (b0, b1, b2, _, a1, a2) in enumerate(sos):
+            pole = np.roots([1, a1, a2])
+            pole = pole[np.argmax(pole.imag)]
+            if pole.imag <= 0:
+                raise ValueError("The coupled form needs a complex pole pair in every section")
+            cr, ci = pole.real, pole.imag
+            
+            # Numerator of the state-space realization with g = 1
+            c1 = b1 - b0 * a1
+            c2 = (b2 - b0 * a2 + c1 * cr) / ci
+            
+            # Scale the states so that their L1 norm, driven by the input of the whole 
+            # cascade, stays below 1 which keeps them from overflowing in Q31. The impulse
+            # responses come from the spectra on a grid of twice their length, the part the 
+            # FFT wraps around has long decayed, which keeps scipy.signal out of --headless.
+            denominator = np.fft.rfft([1, a1, a2], 2 * length)
+            v1 = np.fft.irfft(cascade * np.fft.rfft([0, 1, -cr], 2 * length) / denominator)[:length]
+            v2 = np.fft.irfft(cascade * np.fft.rfft([0, 0, ci], 2 * length) / denominator)[:length]
+            g = 2.0 ** -np.ceil(np.log2(max(np.abs(v1).sum(), np.abs(v2).sum())))
+            
+            coupled[i] = [b0, g, cr, ci, c1 / g, c2 / g]
+            cascade = cascade * np.fft.rfft([b0, b1, b2], 2 * length) / denominator
+            
+        return coupled
+        
+    def compare_biquad_structures(self, num_samples=4000):
+    
+        # Run every band through the fixed-point models of the kernels available in Eq_ARM.c 
+        # and compare them with the floating point filter. The input is white noise scaled 
+        # down by 2^-3 like the input of ARM_Equalizer.
+        rng = np.random.default_rng(0)
+        noise = rng.uniform(-1, 1, num_samples) / 8
+        x = [int(v) for v in np.round(noise * (2**31))]
+        
+        kernels = BIQUAD_KERNELS
+        
+        print(f"\n~~~~~~~~~~ Biquad structure comparison (SNR [dB] vs float, MACs per sample) ~~~~~~~~~~ \n")
+        print("Band\t" + "\t".join(f"{name:>12}" for name in kernels))
+        
+        for i, sos in enumerate(self.sos_list):
+            reference = signal.sosfilt(sos, noise)
+            df1 = np.round(np.hstack((sos[:, :3], -sos[:, 4:])) / (2 ** POSTSHIFT) * (2**31)).astype(np.int64)
+            coupled = np.round(self.sos_to_coupled(sos) / (2 ** POSTSHIFT) * (2**31)).astype(np.int64)
+            
+            row = []
+            for name, (kernel, _, _) in kernels.items():
+                y = x
+                for stage in (coupled if kernel is coupled_q31 else df1):
+                    y = kernel([int(c) for c in stage], y, POSTSHIFT)
+                error = np.array(y) / (2**31) - reference
+                snr = 10 * np.log10(np.sum(reference**2) / max(np.sum(error**2), 1e-30))
+                row.append(f"{snr:12.1f}")
+            print(f"{i + 1}\t" + "\t".join(row))
+        
+        print("MACs\t" + "\t".join(f"{macs * NUMSTAGES:>12}" for _, macs, _ in kernels.values()))
+        print("State\t" + "\t".join(f"{state:>12}" for _, _, state in kernels.values()))
+        print("\n(DF1 32x64 counts each 32x64 product as two 32x32 multiplies)\n")
+        
+        return
+        
+    def check_equalizer_model(self, num_samples=CHECK_MODEL_SAMPLES):
+    
+        # Check the vectorized model equalizer_q31() with its default gains. With the eq_arm 
+        # extension built for the bank rate it has to match the C engine on noise, whose 
+        # block exponents move from block to block. Without it, every block starts at full 
+        # scale so that the exponent stays at -HEADROOM_BITS (the 2^-3 input scaling) and 
+        # the bands are run through the scalar models of the kernels, then mixed with the 
+        # default gains, saturated and converted like ARM_Equalizer_mix() does.
+        rng = np.random.default_rng(0)
+        x = np.round(rng.normal(0, 2000, num_samples) * np.repeat(rng.uniform(0, 4, num_samples // 64 + 1), 64)[:num_samples])
+        x = np.clip(x, -32768, 32767).astype(np.int16)
+        coefs = np.reshape(np.asarray(self.q31_list, dtype=np.int64), (NUM_BANDS, NUMSTAGES, 5))
+        
+        eq_arm = self.arm_engine()
+        if eq_arm is not None:
+            reference_name = "C engine (eq_arm)"
+            num_samples -= num_samples % eq_arm.SAMPLES_PER_TRANSFER
+            x = x[:num_samples]
+            reference = np.empty_like(x)
+            eq_arm.reset()
+            eq_arm.process(x, reference)
+            model = equalizer_q31(x, coefs, block=eq_arm.SAMPLES_PER_TRANSFER)
+        else:
+            reference_name = "scalar kernel models"
+            x[::SAMPLES_PER_TRANSFER] = 32767
+            gains = [(1 << GAIN_FRACTION_BITS) << SCALE_FACTOR] + [1 << GAIN_FRACTION_BITS] * (NUM_BANDS - 1)
+            mix = np.zeros(num_samples, dtype=object)
+            for band in range(NUM_BANDS):
+                kernel = df1_32x64_q31 if band < LOW_BANDS else df1_q31
+                y = [int(v) << (16 - HEADROOM_BITS) for v in x]
+                for stage in coefs[band]:
+                    y = kernel([int(c) for c in stage], y, POSTSHIFT)
+                mix += np.array([(v * gains[band]) >> GAIN_FRACTION_BITS for v in y], dtype=object)
+            reference = np.array([min(max(v << HEADROOM_BITS, -2**31), 2**31 - 1) >> 16 for v in mix], dtype=np.int16)
+            model = equalizer_q31(x, coefs)
+            
+        mismatches = np.flatnonzero(model != reference)
+        print(f"\n~~~~~~~~~~ Check of equalizer_q31 against the {reference_name} ~~~~~~~~~~ \n")
+        if len(mismatches) == 0:
+            print(f"Bit exact on all {num_samples} samples\n")
+        else:
+            print(f"{len(mismatches)} of {num_samples} samples differ, the first at sample {mismatches[0]} "
+                  f"({model[mismatches[0]]} instead of {reference[mismatches[0]]})\n")
+        
+        return len(mismatches) == 0
+        
+    def zero_pairings(self, zeros):
+    
+        # All the distinct ways of grouping the zeros into pairs, complex zeros always 
+        # stay with their conjugate so that the sections have real coefficients
+        if len(zeros) == 0:
+            return [[]]
+            
+        first, rest = zeros[0], list(zeros[1:])
+        if abs(first.imag) > 1e-12:
+            partners = [int(np.argmin(np.abs(np.array(rest) - np.conj(first))))]
+        else:
+            partners = [j for j, z in enumerate(rest) if abs(z.imag) <= 1e-12]
+            
+        pairings, seen = [], set()
+        for j in partners:
+            key = np.round(rest[j], 9)
+            if key in seen:
+                continue
+            seen.add(key)
+            for tail in self.zero_pairings(rest[:j] + rest[j + 1:]):
+                pairings.append([(first, rest[j])] + tail)
+                
+        return pairings
+        
+    def sos_candidates(self, z, p, k):
+    
+        # Every pole-zero pairing and stage ordering of the filter as unscaled sections
+        pole_pairs = [(q, np.conj(q)) for q in p if q.imag > 0]
+        if 2 * len(pole_pairs) != len(p):
+            raise ValueError("The optimizer expects complex pole pairs only")
+        
+        seen = set()
+        for zero_pairs in self.zero_pairings(list(z)):
+            for poles in itertools.permutations(pole_pairs):
+                for zeros in itertools.permutations(zero_pairs):
+                    key = tuple(np.round(np.hstack(poles + zeros).real, 9)) + tuple(np.round(np.hstack(poles).imag, 9))
+                    if key in seen:
+                        continue
+                    seen.add(key)
+                    
+                    sos = np.zeros((len(poles), 6))
+                    for i, (zp, pp) in enumerate(zip(zeros, poles)):
+                        sos[i, :3] = np.real(np.poly(zp))
+                        sos[i, 3:] = np.real(np.poly(pp))
+                    yield sos
+        
+    def distribute_gain(self, sos, k, strategy, impulse):
+    
+        # Spread the overall gain k over the stages:
+        #   'first' - everything in the first stage, as zpk2sos does
+        #   'linf'  - the peak magnitude of the response after every stage is 1
+        #   'l2'    - the energy of the impulse response after every stage is 1
+        sos = sos.copy()
+        if strategy == "first":
+            sos[0, :3] *= k
+            return sos
+        
+        remaining = k
+        response = impulse
+        for i in range(len(sos) - 1):
+            stage = signal.sosfilt(sos[i:i + 1], response)
+            if strategy == "linf":
+                norm = np.max(np.abs(np.fft.rfft(stage)))
+            else:
+                norm = np.sqrt(np.sum(stage**2))
+            sos[i, :3] /= norm
+            remaining *= norm
+            response = stage / norm
+        sos[-1, :3] *= remaining
+        
+        return sos
+        
+    def noise_gains(self, sos, impulse):
+    
+        # Analytic roundoff noise and overflow figures of one cascade, these hardly change
+        # with the coefficient quantization so the float sections are used:
+        #   - the truncation noise power at the output in LSB^2 for each kind of noise 
+        #     shaping of OPT_KERNELS, summed over the stages. Truncation adds LSB^2 / 12 of 
+        #     white noise plus a bias of -LSB / 2, and the bias usually dominates as it goes
+        #     through the large DC gain of poles close to z = 1,
+        #   - the worst L1 norm of the response after each stage times the input scale,
+        #     a ratio >= 1 means a full scale input can overflow.
+        gains = {"state": 0, "ef": 0, "output": 0}
+        overflow = 0
+        response = impulse
+        for i in range(len(sos)):
+            response = signal.sosfilt(sos[i:i + 1], response)
+            overflow = max(overflow, np.sum(np.abs(response)) * OPT_INPUT_SCALE)
+            
+            for shaping in gains:
+                if shaping == "output":
+                    noise = impulse
+                else:
+                    noise = signal.lfilter([1, -1] if shaping == "ef" else [1], sos[i, 3:], impulse)
+                if i + 1 < len(sos):
+                    noise = signal.sosfilt(sos[i + 1:], noise)
+                gains[shaping] += np.sum(noise**2) / 12 + np.sum(noise)**2 / 4
+                
+        return gains, overflow
+        
+    def quantization_error(self, sos, bits, postshift, impulse, reference):
+    
+        # Energy of the error in the impulse response caused by quantizing the coefficients
+        # to the given word length and postShift, for a full scale white input. Returns None
+        # if the coefficients do not fit the postShift.
+        lsb = 2.0 ** -(bits - 1)
+        scale = 2.0 ** postshift
+        if np.max(np.abs(sos[:, [0, 1, 2, 4, 5]])) / scale >= 1 - lsb:
+            return None
+            
+        sos_q = np.round(sos / scale / lsb) * lsb * scale
+        sos_q[:, 3] = 1
+        
+        return np.sum((signal.sosfilt(sos_q, impulse) - reference)**2) / 3
+        
+    def optimize_quantization(self, num_taps=1 << 13):
+    
+        # Search the SOS pole-zero pairing, stage ordering, gain distribution and postShift 
+        # of every band for the lowest noise without overflow on each kernel of OPT_KERNELS.
+        # The noise is the truncation noise of all stages (relative to the input scale) plus
+        # the coefficient quantization error, in dBFS.
+        # A band qualifies for a kernel when its noise is below NOISE_TARGET_DB, the 
+        # cheapest qualifying kernel is reported together with its coefficients.
+        impulse = np.zeros(num_taps)
+        impulse[0] = 1
+        self.optimized = []
+        
+        print(f"\n~~~~~~~~~~ Quantization optimizer (best noise [dBFS] per kernel) ~~~~~~~~~~ \n")
+        print("Band\t" + "\t".join(f"{name:>10}" for name in OPT_KERNELS) + "\tCheapest")
+        
+        for i in range(NUM_BANDS):
+            nyquist = 0.5 * self.fs
+            z, p, k = signal.butter(NUMSTAGES, [self.edges[i] / nyquist, self.edges[i + 1] / nyquist], btype='band', output='zpk')
+            reference = signal.sosfilt(signal.zpk2sos(z, p, k), impulse)
+            
+            best = {name: None for name in OPT_KERNELS}
+            for sos in self.sos_candidates(z, p, k):
+                for strategy in ("first", "linf", "l2"):
+                    scaled = self.distribute_gain(sos, k, strategy, impulse)
+                    gains, overflow = self.noise_gains(scaled, impulse)
+                    if overflow >= 1:
+                        continue
+                        
+                    for bits in sorted({bits for bits, _ in OPT_KERNELS.values()}):
+                        for postshift in OPT_POSTSHIFTS:
+                            error = self.quantization_error(scaled, bits, postshift, impulse, reference)
+                            if error is None:
+                                continue
+                            
+                            for name, (kernel_bits, shaping) in OPT_KERNELS.items():
+                                if kernel_bits != bits:
+                                    continue
+                                roundoff = gains[shaping] * 2.0 ** (-2 * (bits - 1)) / OPT_INPUT_SCALE**2
+                                noise = 10 * np.log10(roundoff + error)
+                                if best[name] is None or noise < best[name]["noise"]:
+                                    best[name] = {"noise": noise, "overflow": overflow, "sos": scaled, 
+                                                  "gain": strategy, "postshift": postshift}
+            
+            qualifying = [name for name, b in best.items() if b is not None and b["noise"] < NOISE_TARGET_DB]
+            cheapest = qualifying[0] if qualifying else "none"
+            self.optimized.append({"best": best, "kernel": cheapest})
+            
+            row = [f"{b['noise']:10.1f}" if b is not None else f"{'-':>10}" for b in best.values()]
+            print(f"{i + 1}\t" + "\t".join(row) + f"\t{cheapest}")
+            
+        # Print the coefficients of the selected kernel of every band in the CMSIS layout
+        for i, result in enumerate(self.optimized):
+            if result["kernel"] == "none":
+                continue
+            b = result["best"][result["kernel"]]
+            bits = OPT_KERNELS[result["kernel"]][0]
+            coefs = np.hstack((b["sos"][:, :3], -b["sos"][:, 4:])) / (2 ** b["postshift"])
+            coefs = np.round(coefs * 2 ** (bits - 1))
+            if bits == 16:
+                # arm_biquad_cascade_df1_q15 expects {b0, 0, b1, b2, a1, a2}
+                coefs = np.insert(coefs, 1, 0, axis=1)
+            
+            print("")
+            print("~~~~~~~~~~ Optimized {} Coefficients band {}: postShift {}, gain '{}', overflow ratio {:.2f}: ~~~~~~~~~~ \n".format(
+                result["kernel"], i + 1, b["postshift"], b["gain"], b["overflow"]))
+            print(" ".join("{:.0f}".format(x) for x in np.reshape(coefs, -1)))
+        print("\n")
+        
+        return
+        
+    def bank_initial_state(self):
+    
+        # Zero sosfilt states of all bands, shape (bands, stages, 2)
+        return np.zeros((len(self.sos_list), NUMSTAGES, 2))
+        
+    def filter_bank_block(self, block, zi, gains):
+    
+        # Filter one block through the SOS of all bands, stacked as (bands, stages, 6), and
+        # add the bands up with their gains as they come out. The filter states in zi are 
+        # updated in place and carry over to the next block, so a signal can be filtered
+        # block by block with only one block in flight instead of every band at full length.
+        # sosfilt runs one cascade per call, the bands cannot share a call.
+        sos_bank = np.asarray(self.sos_list)
+        output = np.zeros(len(block))
+        for band in range(len(sos_bank)):
+            filtered, zi[band] = signal.sosfilt(sos_bank[band], block, zi=zi[band])
+            filtered *= gains[band]
+            output += filtered
+            
+        return output
         
     def apply_filters_and_print_python(self):
     
-        # Filter the signal using a digital IIR filter defined by sos.
-        signal_list = [sosfilt(sos, self.input_signal) for sos in self.sos_list]
-
-        # Scale the bands here, for example the first band scaled by a factor of 1.
+        # Scale the bands here, the first band by 2^SCALE_FACTOR like the C engine does.
         # This is where the "equalization" portion would be applied to tune the bands
-        signal_list[0] *= 1
+        gains = np.ones(len(self.sos_list))
+        gains[0] *= 2 ** SCALE_FACTOR
         
-        # Sum up the signals to reconstruct the signal
-        final_signal = np.sum(signal_list, axis=0)
+        # Filter the signal through the bank of digital IIR filters defined by sos, and sum 
+        # up the bands to reconstruct the signal, FILTER_BLOCK_SIZE samples at a time,
+        # and collect its spectrum on the way
+        zi = self.bank_initial_state()
+        final_signal = np.empty(len(self.input_signal))
+        spectrum = WelchSpectrum(self.fs)
+        for start in range(0, len(self.input_signal), FILTER_BLOCK_SIZE):
+            block = self.input_signal[start:start + FILTER_BLOCK_SIZE]
+            final_signal[start:start + len(block)] = self.filter_bank_block(block, zi, gains)
+            spectrum.update(final_signal[start:start + len(block)])
+        self.spectra["SciPy"] = spectrum
 
         # Output the signal to a wav file
         output_filename = "filtered_output.wav"
@@ -215,17 +1254,17 @@ class SignalProcessor:
         plt.figure(figsize=(FIG_WIDTH, FIG_HEIGHT))
         
         plt.subplot(2, 1, 1)
-        plt.plot(np.arange(len(final_signal)) / self.fs, final_signal, label='SciPy Filtered Signal')
+        self.plot_min_max(final_signal, self.fs, label='SciPy Filtered Signal')
         plt.title('Python SciPy: Time Domain for the Filtered Signal')
         plt.xlabel('Time (s)')
         plt.ylabel('Amplitude')
         plt.legend()
         
         plt.subplot(2, 1, 2)
-        plt.magnitude_spectrum(final_signal, Fs=self.fs, scale='dB')
+        self.plot_spectrum(spectrum)
         plt.title('Python SciPy: Frequency Domain for the Filtered Signal')
         plt.xlabel('Frequency (Hz)')
-        plt.ylabel('Magnitude (dB)')
+        plt.ylabel('Power (dB/Hz)')
         
         plt.tight_layout()
         
@@ -234,69 +1273,153 @@ class SignalProcessor:
         
         return
         
-    def apply_filters_and_print_ARM(self):
+    def arm_engine(self):
     
-        # Local variables
-        signal_ARM = []
-        
-         # Loop over the number of number of frequency bands
-        for i in range(0, NUM_BANDS):
-            sos = self.sos_list[i]
+        # The eq_arm extension of Eq_ARM_module.c if it is built and runs at the sample rate 
+        # of the bank, None otherwise. Built with SRC it expects the stream rate instead.
+        try:
+            engine = importlib.import_module("eq_arm")
+        except ImportError:
+            return None
+        if engine.STREAM_SAMPLE_RATE_HZ != self.fs:
+            print(f"eq_arm runs at {engine.STREAM_SAMPLE_RATE_HZ} Hz instead of {self.fs} Hz and is not used")
+            return None
             
-            # Reshape the sos and scale the coefficents down based off of the postshift
-            coefs=np.reshape(np.hstack((sos[:,:3],-sos[:,4:])), NUMSTAGES * 5)
-            coefs = coefs / (POSTSHIFT ** 2)
+        return engine
+        
+    def arm_output(self):
+    
+        # Name and wav file of the output of the ARM path, the C engine or its emulation
+        if self.engine is not None:
+            return "C", C_OUT_FILENAME
+        
+        return "ARM", ARM_OUT_FILENAME
+        
+    def arm_bank_init(self):
+    
+        # The C engine itself when eq_arm is available, restarted for the new signal. 
+        # Otherwise one CMSIS biquad instance per band; the cmsisdsp wrapper keeps the 
+        # filter state inside the instance, so it carries over from one arm_bank_block() 
+        # to the next.
+        self.engine = self.arm_engine()
+        if self.engine is not None:
+            self.engine.reset()
+            return []
             
-            # Convert the coefficients to Q31 
-            coefsQ31 = (coefs * (2**31)) 
-            coefsQ31= np.round(coefsQ31)
+        instances = []
+        for coefsQ31 in self.q31_list:
+        
+            # The sos reshaped, scaled down based off of the postshift and converted to Q31 
+            # by design_bank()
             self.coefs = coefsQ31
         
-            # Initialize the biquad filter and apply the filter
+            # Initialize the biquad filter
             state = np.zeros(NUMSTAGES * 4)
             biquadQ31 = dsp.arm_biquad_casd_df1_inst_q31()
             dsp.arm_biquad_cascade_df1_init_q31(biquadQ31, NUMSTAGES, self.coefs, state, POSTSHIFT)
-
-            # Convert the signal to Q31 and scale it down for filtering
-            sigQ31 = self.input_signal * (2**31)
-            sigQ31 = sigQ31 / 4
-
+            instances.append(biquadQ31)
+            
+        return instances
+        
+    def arm_bank_block(self, instances, block, gains):
+    
+        # eq_arm takes the int16 samples of the target and runs Eq_ARM.c on them, with the
+        # band gains of the engine
+        if self.engine is not None:
+            samples = np.clip(np.round(block * 32768), -32768, 32767).astype(np.int16)
+            self.engine.process(samples, samples)
+            return samples / 32768
+            
+        # Convert the signal to Q31 and scale it down for filtering
+        sigQ31 = block * (2**31)
+        sigQ31 = sigQ31 / 4
+        
+        output = np.zeros(len(block))
+        for band, biquadQ31 in enumerate(instances):
+        
             # Apply the filter
             res2 = dsp.arm_biquad_cascade_df1_q31(biquadQ31, sigQ31) 
 
-            # Scale the signal back up and reconvert it back
+            # Scale the signal back up, reconvert it back and add it up with its gain
             res2 *= 4
             res2 = res2 / (2**31)
-
-            # Append this new signal to an array
-            signal_ARM.append(res2)
-
-        # Scale the bands here, for example the first band scaled by a factor of 1.
+            output += gains[band] * res2
+            
+        return output
+        
+    def stream_filters(self, filename=INPUT_FILENAME, block_size=FILTER_BLOCK_SIZE):
+    
+        # Streaming version of load_input_signal() and the two apply_filters_and_print 
+        # functions for recordings of any length. The wav file is read block by block with 
+        # soundfile (mixed down to mono like librosa.load), both banks carry their filter 
+        # states from block to block and both outputs are written as they come, so the 
+        # memory stays at a few blocks. Only the spectra of the outputs, collected on the 
+        # way, are plotted.
+        gains = np.ones(len(self.sos_list))
+        gains[0] *= 2 ** SCALE_FACTOR
+        
+        zi = self.bank_initial_state()
+        instances = self.arm_bank_init()
+        arm_name, arm_filename = self.arm_output()
+        self.spectra = {"SciPy": WelchSpectrum(self.fs), arm_name: WelchSpectrum(self.fs)}
+        num_samples = 0
+        
+        with sf.SoundFile(SCIPY_OUT_FILENAME, "w", samplerate=self.fs, channels=1) as scipy_out, \
+             sf.SoundFile(arm_filename, "w", samplerate=self.fs, channels=1) as arm_out:
+            for block in sf.blocks(filename, blocksize=block_size, dtype="float32", always_2d=True):
+                block = np.mean(block, axis=1)
+                scipy_block = self.filter_bank_block(block, zi, gains)
+                arm_block = self.arm_bank_block(instances, block, gains)
+                scipy_out.write(scipy_block)
+                arm_out.write(arm_block)
+                self.spectra["SciPy"].update(scipy_block)
+                self.spectra[arm_name].update(arm_block)
+                num_samples += len(block)
+                
+        print(f"Streamed {num_samples} samples of {filename} to {SCIPY_OUT_FILENAME} and {arm_filename}\n")
+        
+        return
+        
+    def apply_filters_and_print_ARM(self):
+    
+        # Scale the bands here, the first band by 2^SCALE_FACTOR like the C engine does.
         # This is where the "equalization" portion would be applied to tune the bands
-        signal_ARM[0] *= 1 
+        gains = np.ones(len(self.sos_list))
+        gains[0] *= 2 ** SCALE_FACTOR
         
-        # Sum up all the signals together to reconstruction the original signal
-        final_signal_ARM = np.sum(signal_ARM, axis=0)
+        # Filter the signal through the C engine, or the CMSIS biquads of every band, and 
+        # sum up all the signals together to reconstruction the original signal, 
+        # FILTER_BLOCK_SIZE samples at a time like the SciPy bank, and collect its spectrum 
+        # on the way
+        instances = self.arm_bank_init()
+        arm_name, arm_filename = self.arm_output()
+        final_signal_ARM = np.empty(len(self.input_signal))
+        spectrum = WelchSpectrum(self.fs)
+        for start in range(0, len(self.input_signal), FILTER_BLOCK_SIZE):
+            block = self.input_signal[start:start + FILTER_BLOCK_SIZE]
+            final_signal_ARM[start:start + len(block)] = self.arm_bank_block(instances, block, gains)
+            spectrum.update(final_signal_ARM[start:start + len(block)])
+        self.spectra[arm_name] = spectrum
 
         # Output the file name
-        output_filename = ARM_OUT_FILENAME
+        output_filename = arm_filename
         sf.write(output_filename, final_signal_ARM, self.fs)
 
         # Plot resulting signal
         plt.figure(figsize=(FIG_WIDTH, FIG_HEIGHT))
         
         plt.subplot(2, 1, 1)
-        plt.plot(np.arange(len(final_signal_ARM)) / self.fs, final_signal_ARM, label='ARM Filtered Signal')
-        plt.title('ARM: Time Domain for the Filtered Signal')
+        self.plot_min_max(final_signal_ARM, self.fs, label=f'{arm_name} Filtered Signal')
+        plt.title(f'{arm_name}: Time Domain for the Filtered Signal')
         plt.xlabel('Time (s)')
         plt.ylabel('Amplitude')
         plt.legend()
         
         plt.subplot(2, 1, 2)
-        plt.magnitude_spectrum(final_signal_ARM, Fs=self.fs, scale='dB')
-        plt.title('ARM: Frequency Domain for the Filtered Signal')
+        self.plot_spectrum(spectrum)
+        plt.title(f'{arm_name}: Frequency Domain for the Filtered Signal')
         plt.xlabel('Frequency (Hz)')
-        plt.ylabel('Magnitude (dB)')
+        plt.ylabel('Power (dB/Hz)')
         
         plt.tight_layout()
         
@@ -304,11 +1427,36 @@ class SignalProcessor:
         
 if __name__ == "__main__":
 
+    # ~~~~~~~~~~~~~ Headless Mode ~~~~~~~~~~~~~~
+
+    # Only design the bank and write it out, no signal, plots or SciPy/ARM comparison
+    if HEADLESS or "--headless" in sys.argv[1:]:
+        processor = SignalProcessor()
+        processor.calculate_centers(BASE_FREQUENCY, NUM_BANDS+1, verbose=False)
+        processor.design_bank()
+        processor.export_bank()
+        
+        if GENERATE_RATE_TABLE:
+            processor.generate_rate_table()
+            
+        if GENERATE_GAIN_TABLE:
+            processor.generate_gain_table()
+            
+        if CHECK_MODEL or "--check-model" in sys.argv[1:]:
+            processor.check_equalizer_model()
+            
+        sys.exit(0)
+
     # ~~~~~~~~~~ Signal Generation ~~~~~~~~~~~~~
 
+    streaming = STREAM_INPUT and not GENERATE_SIGNAL
+    
     if GENERATE_SIGNAL:
         processor = SignalProcessor()
         processor.generate_input_signal()
+    elif streaming:
+        # The file is only read block by block when the filters are applied
+        processor = SignalProcessor()
     else:
         processor = SignalProcessor()
         processor.load_input_signal(filename=INPUT_FILENAME)   
@@ -317,14 +1465,38 @@ if __name__ == "__main__":
 
     processor.calculate_centers(BASE_FREQUENCY, NUM_BANDS+1)
     processor.plot_bandpass_filter_response()
+    processor.export_bank()
+    
+    if GENERATE_RATE_TABLE:
+        processor.generate_rate_table()
+        
+    if GENERATE_GAIN_TABLE:
+        processor.generate_gain_table()
+        
+    if COMPARE_STRUCTURES:
+        processor.compare_biquad_structures()
+        
+    if OPTIMIZE_QUANTIZATION:
+        processor.optimize_quantization()
+        
+    if CHECK_MODEL or "--check-model" in sys.argv[1:]:
+        processor.check_equalizer_model()
        
     # ~~~~~~~ Python Filter Application ~~~~~~~~
 
-    processor.apply_filters_and_print_python()
+    if streaming:
+        processor.stream_filters(filename=INPUT_FILENAME)
+    else:
+        processor.apply_filters_and_print_python()
 
     # ~~~~~~~~~ ARM Filter Application ~~~~~~~~~
 
-    processor.apply_filters_and_print_ARM()
+    if not streaming:
+        processor.apply_filters_and_print_ARM()
+        
+    # ~~~~~~~~~~~ Compare the Spectra ~~~~~~~~~~~
+    
+    processor.compare_spectra()
 
     # ~~~~~~~~~~~~ Show the plots ~~~~~~~~~~~~~~
 
@@ -0,0 +1,166 @@
+"""
+Filename: Eq_Sweep.py
+Author:   Danny Soppit
+Description: Explores the design space of the equalizer bank. Every combination
+             of the number of bands, biquad stages, postShift, low band kernel
+             and SRC decimation is designed with the SignalProcessor of
+             Eq_SciPy_ARM.py, run through its bit-exact model of ARM_Equalizer
+             and scored against the SciPy floating point bank at the stream
+             rate. The highest band edge every configuration reaches is
+             reported with it, as the SRC limits the bank below the Nyquist
+             frequency of the stream.
+             The configurations are spread over all cores and the Pareto front
+             of cost against accuracy is printed:
+
+             python Eq_Sweep.py
+
+             The results of all configurations are written to SWEEP_FILENAME.
+
+"""
+
+# ~~~~~~~~~~ Python Libraries ~~~~~~~~~~~~~
+
+import itertools
+import json
+import os
+from concurrent.futures import ProcessPoolExecutor
+import numpy as np
+import Eq_SciPy_ARM as eq
+
+# ~~~~~~~~~~ Define Parameters ~~~~~~~~~~~~~
+
+SWEEP_BANDS         = [4, 5, 6, 7, 8] # NUM_BANDS values
+SWEEP_STAGES        = [2, 3, 4]   # NUMSTAGES values
+SWEEP_POSTSHIFTS    = [2, 3, 4, 5] # POSTSHIFT values
+SWEEP_KERNELS       = {"DF1 32x64": eq.LOW_BANDS, "DF1 32x32": 0} # Kernel of the low bands and their number, the other bands run on DF1 32x32 like in Eq_ARM.c
+SWEEP_DECIMATIONS   = [1, 3, 6]   # Stream rate / bank rate, the SRC of Eq_ARM.c runs the bank below the stream rate
+
+STREAM_RATE         = 48000       # Hz, rate of the input and output
+SWEEP_SECONDS       = 0.1         # Length of the white noise input
+SWEEP_SEGMENT       = 1024        # Samples of the input at the same level
+SWEEP_LEVEL_DB      = -40         # dBFS, lowest level of the input segments
+SWEEP_WORKERS       = os.cpu_count() # Processes evaluating configurations
+
+SRC_SPAN            = 16          # Taps of the SRC filters per step of decimation, like in Eq_ARM.c
+SRC_KAISER_BETA     = 7.0         # Kaiser window of the SRC filters
+SRC_EDGE_LIMIT      = 0.9         # SRC cutoff and highest band edge relative to the Nyquist frequency of the bank
+
+SWEEP_FILENAME      = "Eq_Sweep.json"
+
+# ~~~~~~~~~~~~~~~~ Sweep ~~~~~~~~~~~~~~~~~~~
+
+def evaluate(batch):
+
+    # Design, run and score all postShifts of one configuration of the bank. The module 
+    # constants of Eq_SciPy_ARM.py configure SignalProcessor, so the worker sets them to 
+    # the configuration at hand first; banks designed before come from the design cache. 
+    # The postShifts share the shape of the coefficients and are run together through 
+    # the bit-exact model equalizer_q31(), block floating point, unity gains and the 
+    # saturating mix included. The cost is the number of multiplies per stream sample 
+    # (a 32x64 product counts as two) of the bank, the mix and the SRC, the accuracy the 
+    # SNR of the output against the SciPy bank with the same band edges at the stream rate.
+    bands, stages, kernel, decimation = batch
+    results = [{"bands": bands, "stages": stages, "postshift": postshift, "kernel": kernel, "decimation": decimation}
+               for postshift in SWEEP_POSTSHIFTS]
+    eq.NUM_BANDS, eq.NUMSTAGES = bands, stages
+    bank_rate = STREAM_RATE / decimation
+    low_bands = min(SWEEP_KERNELS[kernel], bands)
+
+    processor = eq.SignalProcessor()
+    processor.calculate_centers(eq.BASE_FREQUENCY, bands + 1, verbose=False)
+    try:
+        reference_bank = processor.load_bank(STREAM_RATE, SRC_EDGE_LIMIT / decimation)
+    except ValueError as error:
+        for result in results:
+            result["invalid"] = str(error)
+        return results
+    coverage = processor.band_edges(bank_rate, SRC_EDGE_LIMIT)[-1][1]
+
+    coefficients = []
+    for result in results:
+        eq.POSTSHIFT = result["postshift"]
+        bank = processor.load_bank(bank_rate, SRC_EDGE_LIMIT)
+        result["coverage"] = coverage
+
+        # The Q31 coefficients have to fit the postShift and keep the poles inside the unit circle
+        q31 = np.reshape(bank["q31"], (bands, stages, 5))
+        if np.max(np.abs(q31)) >= 2**31:
+            result["invalid"] = "Coefficients do not fit the postShift"
+            continue
+        if any(np.max(np.abs(np.roots([1, -a1, -a2]))) >= 1
+               for a1, a2 in np.reshape(q31, (-1, 5))[:, 3:] * (2 ** result["postshift"]) / (2**31)):
+            result["invalid"] = "Unstable after quantization"
+            continue
+        coefficients.append(q31)
+
+    valid = [result for result in results if "invalid" not in result]
+    if not valid:
+        return results
+
+    # Noise at a level that changes every SWEEP_SEGMENT samples, so that the block 
+    # exponent moves, the same for every configuration
+    rng = np.random.default_rng(0)
+    num_samples = int(SWEEP_SECONDS * STREAM_RATE)
+    levels = 10 ** (rng.uniform(SWEEP_LEVEL_DB, 0, num_samples // SWEEP_SEGMENT + 1) / 20)
+    x = np.round(rng.uniform(-1, 1, num_samples) * np.repeat(levels, SWEEP_SEGMENT)[:num_samples] * 32767).astype(np.int16)
+    reference = sum(eq.signal.sosfilt(sos, x / 32768) for sos in reference_bank["sos"])
+
+    # The SRC is modelled in floating point around the model of the bank
+    samples = x
+    if decimation > 1:
+        taps = eq.signal.firwin(SRC_SPAN * decimation, SRC_EDGE_LIMIT * bank_rate / 2,
+                                window=("kaiser", SRC_KAISER_BETA), fs=STREAM_RATE)
+        samples = np.clip(np.round(eq.signal.upfirdn(taps, x, 1, decimation)), -32768, 32767).astype(np.int16)
+
+    gains = np.full(bands, 1 << eq.GAIN_FRACTION_BITS)
+    postshifts = [result["postshift"] for result in valid]
+    outputs = eq.equalizer_q31(samples, np.stack(coefficients), postshift=postshifts, low_bands=low_bands,
+                               gains=gains, block=max(1, eq.SAMPLES_PER_TRANSFER // decimation)) / 32768
+
+    macs = bands + sum(eq.BIQUAD_KERNELS["DF1 32x64" if i < low_bands else "DF1 32x32"][1] * stages for i in range(bands))
+    for result, output in zip(valid, outputs):
+        if decimation > 1:
+            delay = len(taps) - 1
+            output = eq.signal.upfirdn(taps * decimation, output, decimation, 1)[delay:delay + len(reference)]
+        error = output - reference
+        result["macs"] = macs / decimation + (2 * SRC_SPAN if decimation > 1 else 0)
+        result["snr"] = 10 * np.log10(np.sum(reference**2) / max(np.sum(error**2), 1e-30))
+
+    return results
+
+def pareto_front(results):
+
+    # The valid configurations that no other one beats in both cost and SNR, cheapest first
+    front = []
+
+    for result in sorted((r for r in results if "invalid" not in r), key=lambda r: (r["macs"], -r["snr"])):
+        if not front or result["snr"] > front[-1]["snr"]:
+            front.append(result)
+
+    return front
+
+if __name__ == "__main__":
+
+    # ~~~~~~~~~~ Evaluate the Configurations ~~~~~~~~~~~~~
+
+    batches = list(itertools.product(SWEEP_BANDS, SWEEP_STAGES, SWEEP_KERNELS, SWEEP_DECIMATIONS))
+
+    with ProcessPoolExecutor(max_workers=SWEEP_WORKERS) as pool:
+        results = list(itertools.chain.from_iterable(pool.map(evaluate, batches)))
+
+    front = pareto_front(results)
+    for result in results:
+        result["pareto"] = any(result is point for point in front)
+
+    with open(SWEEP_FILENAME, "w") as file:
+        json.dump(results, file, indent=2)
+
+    # ~~~~~~~~~~~~~ Print the Pareto Front ~~~~~~~~~~~~~~~~
+
+    valid = sum("invalid" not in result for result in results)
+    print(f"\n~~~~~~~~~~ Pareto front of {valid} valid out of {len(results)} configurations ~~~~~~~~~~ \n")
+    print(f"{'MACs/sample':>12}{'SNR [dB]':>10}{'Bands':>7}{'Stages':>8}{'PostShift':>11}  {'Kernel':<12}{'Decimation':>11}{'Top [Hz]':>10}")
+    for result in front:
+        print(f"{result['macs']:12.1f}{result['snr']:10.1f}{result['bands']:7}{result['stages']:8}{result['postshift']:11}  "
+              f"{result['kernel']:<12}{result['decimation']:11}{result['coverage']:10.0f}")
+    print(f"\nWrote all results to {SWEEP_FILENAME}\n")
@@ -0,0 +1,59 @@
+"""
+Filename: setup.py
+Author:   Danny Soppit
+Description: Builds the eq_arm Python extension of Eq_ARM_module.c, which runs
+             the equalizer engine of Eq_ARM.c on the host. It is compiled
+             against the CMSIS-DSP sources, the same library the target uses:
+
+             CMSIS_DSP=/path/to/CMSIS-DSP python setup.py build_ext --inplace
+
+             The configuration of Eq_ARM.c can be set with EQ_DEFINES, e.g.
+             EQ_DEFINES="EQ_PRESETS=1 STREAM_SAMPLE_RATE_HZ=48000".
+
+"""
+
+# ~~~~~~~~~~ Python Libraries ~~~~~~~~~~~~~
+
+import os
+from setuptools import setup, Extension
+
+# ~~~~~~~~~~ Define Parameters ~~~~~~~~~~~~~
+
+CMSIS_DSP  = os.environ.get("CMSIS_DSP", "CMSIS-DSP")   # Checkout of https://github.com/ARM-software/CMSIS-DSP
+EQ_DEFINES = os.environ.get("EQ_DEFINES", "").split()   # NAME=VALUE overrides of the Eq_ARM.c defines
+
+# The CMSIS-DSP functions Eq_ARM.c calls
+CMSIS_SOURCES = [
+    "FilteringFunctions/arm_biquad_cascade_df1_init_q31.c",
+    "FilteringFunctions/arm_biquad_cascade_df1_q31.c",
+    "FilteringFunctions/arm_biquad_cas_df1_32x64_init_q31.c",
+    "FilteringFunctions/arm_biquad_cas_df1_32x64_q31.c",
+    "FilteringFunctions/arm_fir_decimate_init_q31.c",
+    "FilteringFunctions/arm_fir_decimate_q31.c",
+    "FilteringFunctions/arm_fir_interpolate_init_q31.c",
+    "FilteringFunctions/arm_fir_interpolate_q31.c",
+    "StatisticsFunctions/arm_absmax_q15.c",
+    "SupportFunctions/arm_q31_to_q15.c",
+]
+
+# ~~~~~~~~~~~~~~ Extension ~~~~~~~~~~~~~~~~~
+
+define_macros = [("__GNUC_PYTHON__", None)]
+for define in EQ_DEFINES:
+    name, _, value = define.partition("=")
+    define_macros.append((name, value or None))
+
+eq_arm = Extension(
+    "eq_arm",
+    sources=["Eq_ARM_module.c"] + [os.path.join(CMSIS_DSP, "Source", source) for source in CMSIS_SOURCES],
+    include_dirs=[".", os.path.join(CMSIS_DSP, "Include"), os.path.join(CMSIS_DSP, "PrivateInclude")],
+    define_macros=define_macros,
+    extra_compile_args=["-std=gnu11", "-O3"],
+)
+
+setup(
+    name="eq_arm",
+    version="1.0",
+    description="Equalizer engine of Eq_ARM.c as a Python extension",
+    ext_modules=[eq_arm],
+)